@@ -0,0 +1,396 @@
+#include "ArrowIpc.h"
+#include "FileIO.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+//   Schema.fbs / Message.fbs / File.fbs  Arrow
+const std::int16_t MetadataV5 = 4;
+const std::uint8_t HeaderSchema = 1;
+const std::uint8_t HeaderRecordBatch = 3;
+const std::uint8_t TypeFloatingPoint = 3;
+const std::uint8_t TypeUtf8 = 5;
+const std::int16_t PrecisionDouble = 2;
+
+const std::size_t BufferAlign = 64;
+const std::uint32_t Continuation = 0xFFFFFFFFu;
+const char FileMagic[6] = { 'A', 'R', 'R', 'O', 'W', '1' };
+
+std::size_t padTo(std::size_t n, std::size_t align) { return (n + align - 1) & ~(align - 1); }
+
+//   flatbuffers:      ,
+//     ,    .
+//       .
+class FlatBuilder {
+public:
+    FlatBuilder() : buf(256), head(256), minAlign(1), tableStart(0) {}
+
+    std::uint32_t size() const { return static_cast<std::uint32_t>(buf.size() - head); }
+
+    std::uint32_t string(std::string_view s)
+    {
+        align(4, s.size() + 1);
+        push<std::uint8_t>(0);
+        bytes(s.data(), s.size());
+        push<std::uint32_t>(static_cast<std::uint32_t>(s.size()));
+        return size();
+    }
+
+    std::uint32_t offsetVector(const std::vector<std::uint32_t>& items)
+    {
+        align(4, items.size() * 4);
+        for (std::size_t i = items.size(); i-- > 0;) ref(items[i]);
+        push<std::uint32_t>(static_cast<std::uint32_t>(items.size()));
+        return size();
+    }
+
+    std::uint32_t structVector(const void* data, std::size_t elemSize, std::size_t count)
+    {
+        align(4, elemSize * count);
+        align(8, elemSize * count);
+        bytes(data, elemSize * count);
+        push<std::uint32_t>(static_cast<std::uint32_t>(count));
+        return size();
+    }
+
+    void startTable()
+    {
+        fields.clear();
+        tableStart = size();
+    }
+
+    template <class T>
+    void add(std::uint16_t id, T value)
+    {
+        align(sizeof(T));
+        push(value);
+        fields.push_back(std::make_pair(id, size()));
+    }
+
+    void addRef(std::uint16_t id, std::uint32_t target)
+    {
+        ref(target);
+        fields.push_back(std::make_pair(id, size()));
+    }
+
+    std::uint32_t endTable()
+    {
+        align(4);
+        push<std::int32_t>(0);
+        std::uint32_t tableEnd = size();
+
+        std::uint16_t count = 0;
+        for (auto& f : fields) count = std::max<std::uint16_t>(count, f.first + 1);
+        std::vector<std::uint16_t> slots(count, 0);
+        for (auto& f : fields) slots[f.first] = static_cast<std::uint16_t>(tableEnd - f.second);
+
+        for (std::size_t i = slots.size(); i-- > 0;) push(slots[i]);
+        push(static_cast<std::uint16_t>(tableEnd - tableStart));
+        push(static_cast<std::uint16_t>(4 + 2 * count));
+
+        //     vtable,    
+        std::int32_t soffset = static_cast<std::int32_t>(size() - tableEnd);
+        std::memcpy(&buf[buf.size() - tableEnd], &soffset, sizeof(soffset));
+        fields.clear();
+        return tableEnd;
+    }
+
+    std::vector<std::uint8_t> finish(std::uint32_t root)
+    {
+        align(std::max<std::size_t>(minAlign, 4), 4);
+        ref(root);
+        return std::vector<std::uint8_t>(buf.begin() + static_cast<std::ptrdiff_t>(head), buf.end());
+    }
+
+private:
+    void reserve(std::size_t n)
+    {
+        if (head >= n) return;
+        std::size_t used = size();
+        std::size_t cap = std::max(buf.size() * 2, used + n);
+        std::vector<std::uint8_t> grown(cap);
+        std::memcpy(grown.data() + cap - used, buf.data() + head, used);
+        buf.swap(grown);
+        head = cap - used;
+    }
+
+    void bytes(const void* data, std::size_t len)
+    {
+        reserve(len);
+        head -= len;
+        if (len) std::memcpy(&buf[head], data, len);
+    }
+
+    template <class T>
+    void push(T value) { bytes(&value, sizeof(value)); }
+
+    void align(std::size_t a, std::size_t extra = 0)
+    {
+        minAlign = std::max(minAlign, a);
+        std::size_t pad = (a - (size() + extra) % a) % a;
+        reserve(pad);
+        for (; pad; --pad) buf[--head] = 0;
+    }
+
+    void ref(std::uint32_t target)
+    {
+        align(4);
+        push<std::uint32_t>(size() + 4 - target);
+    }
+
+    std::vector<std::uint8_t> buf;
+    std::size_t head;
+    std::size_t minAlign;
+    std::uint32_t tableStart;
+    std::vector<std::pair<std::uint16_t, std::uint32_t>> fields;
+};
+
+struct FieldNode {
+    std::int64_t length;
+    std::int64_t nullCount;
+};
+
+struct BufferRef {
+    std::int64_t offset;
+    std::int64_t length;
+};
+
+// Block  File.fbs: 4    metaDataLength
+struct FooterBlock {
+    std::int64_t offset;
+    std::int32_t metaDataLength;
+    std::int32_t padding;
+    std::int64_t bodyLength;
+};
+
+std::uint32_t buildSchema(FlatBuilder& fb)
+{
+    const char* names[4] = { "Name", "BasePay", "BonusPercent", "FinalPay" };
+    std::vector<std::uint32_t> fieldRefs;
+    for (int i = 0; i < 4; ++i) {
+        std::uint32_t name = fb.string(names[i]);
+        fb.startTable();
+        if (i > 0) fb.add<std::int16_t>(0, PrecisionDouble);
+        std::uint32_t type = fb.endTable();
+        std::uint32_t children = fb.offsetVector(std::vector<std::uint32_t>());
+
+        fb.startTable();
+        fb.addRef(0, name);
+        fb.add<std::uint8_t>(1, 0);  // nullable = false
+        fb.add<std::uint8_t>(2, i == 0 ? TypeUtf8 : TypeFloatingPoint);
+        fb.addRef(3, type);
+        fb.addRef(5, children);
+        fieldRefs.push_back(fb.endTable());
+    }
+    std::uint32_t fields = fb.offsetVector(fieldRefs);
+
+    fb.startTable();
+    fb.add<std::int16_t>(0, 0);      // little-endian
+    fb.addRef(1, fields);
+    return fb.endTable();
+}
+
+std::vector<std::uint8_t> buildMessage(FlatBuilder& fb, std::uint8_t headerType, std::uint32_t header,
+    std::int64_t bodyLength)
+{
+    fb.startTable();
+    fb.add<std::int64_t>(3, bodyLength);
+    fb.addRef(2, header);
+    fb.add<std::int16_t>(0, MetadataV5);
+    fb.add<std::uint8_t>(1, headerType);
+    return fb.finish(fb.endTable());
+}
+
+void appendBuffer(std::vector<char>& body, std::vector<BufferRef>& refs, const void* data, std::size_t len)
+{
+    BufferRef ref;
+    ref.offset = static_cast<std::int64_t>(body.size());
+    ref.length = static_cast<std::int64_t>(len);
+    refs.push_back(ref);
+    const char* p = static_cast<const char*>(data);
+    body.insert(body.end(), p, p + len);
+    body.resize(padTo(body.size(), BufferAlign), 0);
+}
+
+bool endsWith(const std::string& s, const char* suffix)
+{
+    std::size_t n = std::strlen(suffix);
+    if (s.size() < n) return false;
+    for (std::size_t i = 0; i < n; ++i) {
+        char c = s[s.size() - n + i];
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        if (c != suffix[i]) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+ArrowWriter::Format ArrowWriter::formatForFile(const std::string& filename)
+{
+    return endsWith(filename, ".arrows") ? Format::Stream : Format::File;
+}
+
+bool ArrowWriter::isArrowFile(const std::string& filename)
+{
+    return endsWith(filename, ".arrow") || endsWith(filename, ".arrows") || endsWith(filename, ".feather");
+}
+
+ArrowWriter::ArrowWriter(const std::string& filename, Format format, std::size_t rowsPerBatch)
+    : file(new OutputFile(filename)), format(format), rowsPerBatch(rowsPerBatch ? rowsPerBatch : 65536),
+    offset(0), rowCount(0), closed(false)
+{
+    if (compressionForFile(filename) != Compression::None)
+        throw std::runtime_error("Arrow output cannot be compressed: " + filename);
+    nameOffsets.push_back(0);
+    if (format == Format::File) {
+        writeBytes(FileMagic, sizeof(FileMagic));
+        writePadding(2);
+    }
+    writeSchema();
+}
+
+ArrowWriter::~ArrowWriter() = default;
+
+void ArrowWriter::append(std::string_view name, double base, double bonus)
+{
+    if (nameData.size() + name.size() > 0x7FFFFFFF)
+        throw std::runtime_error("Arrow batch is too large");
+    nameData.append(name.data(), name.size());
+    nameOffsets.push_back(static_cast<std::int32_t>(nameData.size()));
+    basePay.push_back(base);
+    bonusPercent.push_back(bonus);
+    ++rowCount;
+    if (basePay.size() >= rowsPerBatch) flushBatch();
+}
+
+void ArrowWriter::close()
+{
+    if (closed) return;
+    closed = true;
+    if (!basePay.empty()) flushBatch();
+
+    //   
+    std::uint32_t eos[2] = { Continuation, 0 };
+    writeBytes(eos, sizeof(eos));
+
+    if (format == Format::File) {
+        std::vector<FooterBlock> blocks;
+        for (const BlockRef& b : batches) {
+            FooterBlock fbk = { b.offset, b.metaLength, 0, b.bodyLength };
+            blocks.push_back(fbk);
+        }
+        FlatBuilder fb;
+        std::uint32_t schema = buildSchema(fb);
+        std::uint32_t recordBatches = fb.structVector(blocks.data(), sizeof(FooterBlock), blocks.size());
+        std::uint32_t dictionaries = fb.structVector(nullptr, sizeof(FooterBlock), 0);
+        fb.startTable();
+        fb.addRef(1, schema);
+        fb.addRef(2, dictionaries);
+        fb.addRef(3, recordBatches);
+        fb.add<std::int16_t>(0, MetadataV5);
+        std::vector<std::uint8_t> footer = fb.finish(fb.endTable());
+
+        writeBytes(footer.data(), footer.size());
+        std::int32_t footerSize = static_cast<std::int32_t>(footer.size());
+        writeBytes(&footerSize, sizeof(footerSize));
+        writeBytes(FileMagic, sizeof(FileMagic));
+    }
+    file->close();
+}
+
+void ArrowWriter::writeSchema()
+{
+    FlatBuilder fb;
+    std::vector<std::uint8_t> meta = buildMessage(fb, HeaderSchema, buildSchema(fb), 0);
+    writeMessage(meta, std::vector<char>(), nullptr);
+}
+
+void ArrowWriter::flushBatch()
+{
+    std::size_t n = basePay.size();
+    std::vector<double> finalPay(n);
+    for (std::size_t i = 0; i < n; ++i) finalPay[i] = basePay[i] * (1.0 + bonusPercent[i] / 100.0);
+
+    //   null:  validity 
+    std::vector<char> body;
+    std::vector<BufferRef> buffers;
+    appendBuffer(body, buffers, nullptr, 0);
+    appendBuffer(body, buffers, nameOffsets.data(), nameOffsets.size() * sizeof(std::int32_t));
+    appendBuffer(body, buffers, nameData.data(), nameData.size());
+    const std::vector<double>* columns[3] = { &basePay, &bonusPercent, &finalPay };
+    for (const std::vector<double>* c : columns) {
+        appendBuffer(body, buffers, nullptr, 0);
+        appendBuffer(body, buffers, c->data(), n * sizeof(double));
+    }
+
+    std::vector<FieldNode> nodes(4);
+    for (FieldNode& node : nodes) {
+        node.length = static_cast<std::int64_t>(n);
+        node.nullCount = 0;
+    }
+
+    FlatBuilder fb;
+    std::uint32_t buffersRef = fb.structVector(buffers.data(), sizeof(BufferRef), buffers.size());
+    std::uint32_t nodesRef = fb.structVector(nodes.data(), sizeof(FieldNode), nodes.size());
+    fb.startTable();
+    fb.add<std::int64_t>(0, static_cast<std::int64_t>(n));
+    fb.addRef(1, nodesRef);
+    fb.addRef(2, buffersRef);
+    std::uint32_t batch = fb.endTable();
+    std::vector<std::uint8_t> meta = buildMessage(fb, HeaderRecordBatch, batch,
+        static_cast<std::int64_t>(body.size()));
+
+    BlockRef block;
+    writeMessage(meta, body, &block);
+    batches.push_back(block);
+
+    nameOffsets.assign(1, 0);
+    nameData.clear();
+    basePay.clear();
+    bonusPercent.clear();
+}
+
+//  : continuation,  , flatbuffer,
+//  ,      64 ,  
+void ArrowWriter::writeMessage(const std::vector<std::uint8_t>& meta, const std::vector<char>& body,
+    BlockRef* block)
+{
+    std::uint64_t start = offset;
+    std::size_t prefixed = static_cast<std::size_t>(padTo(static_cast<std::size_t>(start) + 8 + meta.size(),
+        BufferAlign) - start);
+    std::int32_t metaLength = static_cast<std::int32_t>(prefixed - 8);
+
+    writeBytes(&Continuation, sizeof(Continuation));
+    writeBytes(&metaLength, sizeof(metaLength));
+    writeBytes(meta.data(), meta.size());
+    writePadding(prefixed - 8 - meta.size());
+    writeBytes(body.data(), body.size());
+
+    if (block) {
+        block->offset = static_cast<std::int64_t>(start);
+        block->metaLength = static_cast<std::int32_t>(prefixed);
+        block->bodyLength = static_cast<std::int64_t>(body.size());
+    }
+}
+
+void ArrowWriter::writeBytes(const void* data, std::size_t len)
+{
+    if (!len) return;
+    file->stream().write(static_cast<const char*>(data), static_cast<std::streamsize>(len));
+    offset += len;
+}
+
+void ArrowWriter::writePadding(std::size_t len)
+{
+    static const char zeros[BufferAlign] = {};
+    while (len) {
+        std::size_t n = std::min(len, sizeof(zeros));
+        writeBytes(zeros, n);
+        len -= n;
+    }
+}
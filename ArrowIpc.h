@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class OutputFile;
+
+// =====   Apache Arrow IPC =====
+//
+//   WorkTypes    Arrow (metadata V5) 
+//  : Name  utf8, BasePay, BonusPercent, FinalPay  float64.
+//         
+// RecordBatch,        .  
+//   64 ,    File   
+//      (pyarrow.memory_map, Arrow C++  ..).
+
+class ArrowWriter {
+public:
+    enum class Format {
+        File,    // "ARROW1" +  + footer      (.arrow, .feather)
+        Stream   //         (.arrows)
+    };
+
+    static Format formatForFile(const std::string& filename);
+    static bool isArrowFile(const std::string& filename);
+
+    ArrowWriter(const std::string& filename, Format format, std::size_t rowsPerBatch = 65536);
+    ~ArrowWriter();
+
+    ArrowWriter(const ArrowWriter&) = delete;
+    ArrowWriter& operator=(const ArrowWriter&) = delete;
+
+    void append(std::string_view name, double basePay, double bonusPercent);
+    //   ,     footer
+    void close();
+
+    std::size_t rows() const { return rowCount; }
+    std::uint64_t bytesWritten() const { return offset; }
+
+private:
+    struct BlockRef {
+        std::int64_t offset;
+        std::int32_t metaLength;
+        std::int64_t bodyLength;
+    };
+
+    void writeSchema();
+    void flushBatch();
+    void writeMessage(const std::vector<std::uint8_t>& meta, const std::vector<char>& body, BlockRef* block);
+    void writeBytes(const void* data, std::size_t len);
+    void writePadding(std::size_t len);
+
+    std::unique_ptr<OutputFile> file;
+    Format format;
+    std::size_t rowsPerBatch;
+    std::uint64_t offset;
+    std::size_t rowCount;
+    bool closed;
+
+    std::vector<std::int32_t> nameOffsets;
+    std::string nameData;
+    std::vector<double> basePay;
+    std::vector<double> bonusPercent;
+    std::vector<BlockRef> batches;
+};
@@ -0,0 +1,178 @@
+#include "ContentHash.h"
+#include "RawFile.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+const std::uint64_t Prime1 = 11400714785074694791ULL;
+const std::uint64_t Prime2 = 14029467366897019727ULL;
+const std::uint64_t Prime3 = 1609587929392839161ULL;
+const std::uint64_t Prime4 = 9650029242287828579ULL;
+const std::uint64_t Prime5 = 2870177450012600261ULL;
+
+const std::size_t ReadBlock = 1 << 20;
+
+inline std::uint64_t rotl(std::uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline std::uint64_t read64(const unsigned char* p)
+{
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline std::uint32_t read32(const unsigned char* p)
+{
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline std::uint64_t round(std::uint64_t acc, std::uint64_t input)
+{
+    acc += input * Prime2;
+    acc = rotl(acc, 31);
+    return acc * Prime1;
+}
+
+inline std::uint64_t mergeRound(std::uint64_t h, std::uint64_t acc)
+{
+    h ^= round(0, acc);
+    return h * Prime1 + Prime4;
+}
+
+} // namespace
+
+// ===== Xxh64 =====
+
+Xxh64::Xxh64(std::uint64_t seed) : seed(seed), total(0), tailSize(0)
+{
+    acc[0] = seed + Prime1 + Prime2;
+    acc[1] = seed + Prime2;
+    acc[2] = seed;
+    acc[3] = seed - Prime1;
+}
+
+void Xxh64::update(const void* data, std::size_t len)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    total += len;
+
+    if (tailSize + len < 32) {
+        std::memcpy(tail + tailSize, p, len);
+        tailSize += len;
+        return;
+    }
+    if (tailSize) {
+        std::size_t fill = 32 - tailSize;
+        std::memcpy(tail + tailSize, p, fill);
+        for (int i = 0; i < 4; ++i) acc[i] = round(acc[i], read64(tail + 8 * i));
+        p += fill;
+        len -= fill;
+        tailSize = 0;
+    }
+    //  :     8 
+    for (; len >= 32; p += 32, len -= 32) {
+        acc[0] = round(acc[0], read64(p));
+        acc[1] = round(acc[1], read64(p + 8));
+        acc[2] = round(acc[2], read64(p + 16));
+        acc[3] = round(acc[3], read64(p + 24));
+    }
+    std::memcpy(tail, p, len);
+    tailSize = len;
+}
+
+std::uint64_t Xxh64::digest() const
+{
+    std::uint64_t h;
+    if (total >= 32) {
+        h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18);
+        for (int i = 0; i < 4; ++i) h = mergeRound(h, acc[i]);
+    }
+    else {
+        h = seed + Prime5;
+    }
+    h += total;
+
+    const unsigned char* p = tail;
+    std::size_t len = tailSize;
+    for (; len >= 8; p += 8, len -= 8) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * Prime1 + Prime4;
+    }
+    if (len >= 4) {
+        h ^= static_cast<std::uint64_t>(read32(p)) * Prime1;
+        h = rotl(h, 23) * Prime2 + Prime3;
+        p += 4;
+        len -= 4;
+    }
+    for (; len; ++p, --len) {
+        h ^= *p * Prime5;
+        h = rotl(h, 11) * Prime1;
+    }
+
+    h ^= h >> 33;
+    h *= Prime2;
+    h ^= h >> 29;
+    h *= Prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+// =====  =====
+
+//      :  st_mtime ,
+// ,     ,   
+FileSignature statFile(const std::string& filename)
+{
+    FileSignature sig;
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA st;
+    if (!GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &st))
+        throw std::runtime_error("cannot stat file: " + filename);
+    sig.size = (static_cast<std::uint64_t>(st.nFileSizeHigh) << 32) | st.nFileSizeLow;
+    // FILETIME     1601 
+    std::int64_t ticks = static_cast<std::int64_t>(
+        (static_cast<std::uint64_t>(st.ftLastWriteTime.dwHighDateTime) << 32) | st.ftLastWriteTime.dwLowDateTime);
+    sig.modifiedTime = (ticks - 116444736000000000LL) * 100;
+#else
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) throw std::runtime_error("cannot stat file: " + filename);
+    sig.size = static_cast<std::uint64_t>(st.st_size);
+#if defined(__APPLE__)
+    sig.modifiedTime = static_cast<std::int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    sig.modifiedTime = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+#endif
+    return sig;
+}
+
+std::uint64_t hashFile(const std::string& filename)
+{
+    RawReader file(filename);
+    Xxh64 hash;
+    std::vector<char> block(ReadBlock);
+    for (;;) {
+        std::size_t n = file.read(block.data(), block.size());
+        if (n == 0) break;
+        hash.update(block.data(), n);
+    }
+    return hash.digest();
+}
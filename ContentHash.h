@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// =====    =====
+//
+// XXH64 (    xxHash)  , 
+// /  ,         
+//    .
+
+class Xxh64 {
+public:
+    explicit Xxh64(std::uint64_t seed = 0);
+
+    void update(const void* data, std::size_t len);
+    std::uint64_t digest() const;
+
+private:
+    std::uint64_t acc[4];
+    std::uint64_t seed;
+    std::uint64_t total;
+    unsigned char tail[32];
+    std::size_t tailSize;
+};
+
+//          
+struct FileSignature {
+    std::uint64_t size = 0;
+    std::int64_t modifiedTime = 0;   //  Unix
+    std::uint64_t contentHash = 0;   // 0   
+};
+
+FileSignature statFile(const std::string& filename);
+//    ( ,  )   XXH64
+std::uint64_t hashFile(const std::string& filename);
@@ -0,0 +1,221 @@
+#include "CsvParser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+const std::size_t InitialBuffer = 1 << 20;
+
+bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+} // namespace
+
+CsvParser::CsvParser(std::istream& in, char separator)
+    : in(&in), buf(InitialBuffer), pos(0), end(0), eof(false), started(false),
+    sep(separator), base(0), recordBegin(0), recordEnd(0),
+    lineNo(0), nextLine(1), term(false) {}
+
+CsvParser::CsvParser(std::vector<char>&& block, char separator, std::size_t firstLine)
+    : in(nullptr), buf(std::move(block)), pos(0), end(0), eof(true), started(true),
+    sep(separator), base(0), recordBegin(0), recordEnd(0),
+    lineNo(0), nextLine(firstLine), term(false)
+{
+    end = buf.size();
+}
+
+//         
+bool CsvParser::fill()
+{
+    if (eof) return false;
+    if (pos > 0) {
+        std::memmove(buf.data(), buf.data() + pos, end - pos);
+        base += pos;
+        end -= pos;
+        pos = 0;
+    }
+    if (end == buf.size()) buf.resize(buf.size() * 2);
+
+    in->read(buf.data() + end, static_cast<std::streamsize>(buf.size() - end));
+    std::size_t got = static_cast<std::size_t>(in->gcount());
+    end += got;
+    if (got == 0) eof = true;
+    return got != 0;
+}
+
+//  "name;base;bonus"   ,    , 
+//   :        .  
+//  ( ),   
+char CsvParser::sniffSeparator(const char* data, std::size_t len)
+{
+    std::size_t counts[3] = { 0, 0, 0 };
+    const char candidates[3] = { ';', ',', '\t' };
+    bool quoted = false;
+    for (std::size_t i = 0; i < len; ++i) {
+        char c = data[i];
+        if (c == '"') quoted = !quoted;
+        else if (!quoted && c == '\n') break;
+        else if (!quoted) {
+            for (int k = 0; k < 3; ++k)
+                if (c == candidates[k]) ++counts[k];
+        }
+    }
+    for (int k = 0; k < 3; ++k) {
+        if (counts[k] == 2) return candidates[k];
+    }
+    char sep = ';';
+    std::size_t best = 0;
+    for (int k = 0; k < 3; ++k) {
+        if (counts[k] > best) {
+            best = counts[k];
+            sep = candidates[k];
+        }
+    }
+    return sep;
+}
+
+// false          
+bool CsvParser::parseRecord(std::size_t& p)
+{
+    fields.clear();
+    scratch.clear();
+    term = false;
+    const char* b = buf.data();
+
+    for (;;) {
+        //  -   :     
+        while (p < end && (b[p] == ' ' || (b[p] == '\t' && sep != '\t'))) ++p;
+        if (p == end && !eof) return false;
+
+        if (p < end && b[p] == '"') {
+            std::size_t start = ++p;
+            bool escaped = false;
+            std::size_t close;
+            for (;;) {
+                const void* q = p < end ? std::memchr(b + p, '"', end - p) : nullptr;
+                if (!q) {
+                    if (!eof) return false;
+                    close = end; //       
+                    p = end;
+                    break;
+                }
+                std::size_t i = static_cast<const char*>(q) - b;
+                if (i + 1 == end && !eof) return false;
+                if (i + 1 < end && b[i + 1] == '"') {
+                    escaped = true;
+                    p = i + 2;
+                    continue;
+                }
+                close = i;
+                p = i + 1;
+                break;
+            }
+
+            if (escaped) {
+                std::size_t at = scratch.size();
+                for (std::size_t i = start; i < close; ++i) {
+                    scratch.push_back(b[i]);
+                    if (b[i] == '"') ++i;
+                }
+                fields.push_back(Field{ at, scratch.size() - at, true });
+            }
+            else {
+                fields.push_back(Field{ start, close - start, false });
+            }
+
+            //       
+            while (p < end && b[p] != sep && b[p] != '\n') ++p;
+            if (p == end && !eof) return false;
+        }
+        else {
+            std::size_t start = p;
+            while (p < end && b[p] != sep && b[p] != '\n') ++p;
+            if (p == end && !eof) return false;
+            std::size_t stop = p;
+            while (stop > start && isBlank(b[stop - 1])) --stop;
+            fields.push_back(Field{ start, stop - start, false });
+        }
+
+        if (p == end) return true;
+        if (b[p] == sep) {
+            ++p;
+            continue;
+        }
+        ++p; // '\n'
+        term = true;
+        return true;
+    }
+}
+
+bool CsvParser::next()
+{
+    if (!started) {
+        started = true;
+        while (end - pos < 3 && fill()) {}
+        const unsigned char* u = reinterpret_cast<const unsigned char*>(buf.data());
+        if (end >= 3 && u[0] == 0xEF && u[1] == 0xBB && u[2] == 0xBF) pos = 3;
+        if (!sep) {
+            while (!eof && !std::memchr(buf.data() + pos, '\n', end - pos)) fill();
+            sep = sniffSeparator(buf.data() + pos, end - pos);
+        }
+    }
+
+    for (;;) {
+        if (pos == end && !fill()) return false;
+
+        std::size_t p = pos;
+        if (!parseRecord(p)) {
+            fill();
+            continue;
+        }
+
+        recordBegin = pos;
+        recordEnd = p;
+        lineNo = nextLine;
+        nextLine += static_cast<std::size_t>(
+            std::count(buf.data() + recordBegin, buf.data() + recordEnd, '\n'));
+        pos = p;
+
+        //   
+        if (fields.size() == 1 && fields[0].length == 0 && !fields[0].unescaped &&
+            std::find(buf.data() + recordBegin, buf.data() + recordEnd, '"') == buf.data() + recordEnd)
+        {
+            continue;
+        }
+        return true;
+    }
+}
+
+std::size_t CsvParser::size() const { return fields.size(); }
+
+std::string_view CsvParser::operator[](std::size_t index) const
+{
+    const Field& f = fields[index];
+    if (f.unescaped) return std::string_view(scratch.data() + f.begin, f.length);
+    return std::string_view(buf.data() + f.begin, f.length);
+}
+
+std::size_t CsvParser::line() const { return lineNo; }
+std::uint64_t CsvParser::offset() const { return base + recordEnd; }
+bool CsvParser::terminated() const { return term; }
+
+std::string_view CsvParser::raw() const
+{
+    return std::string_view(buf.data() + recordBegin, recordEnd - recordBegin);
+}
+
+char CsvParser::separator() const { return sep; }
+
+bool csvToDouble(std::string_view text, double& value)
+{
+    while (!text.empty() && isBlank(text.front())) text.remove_prefix(1);
+    while (!text.empty() && isBlank(text.back())) text.remove_suffix(1);
+    if (!text.empty() && text.front() == '+') text.remove_prefix(1);
+    if (text.empty()) return false;
+    std::from_chars_result r = std::from_chars(text.data(), text.data() + text.size(), value);
+    return r.ec == std::errc() && r.ptr == text.data() + text.size();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// =====  CSV (RFC 4180) =====
+//
+//   "name;base;bonus",  ,   NativeDb::exportToFile:
+// UTF-8 BOM,        "" .
+//  (';', ','  )    .
+//      string_view    ,
+//   ;     next().
+
+class CsvParser {
+public:
+    explicit CsvParser(std::istream& in, char separator = 0);
+    //      (   );
+    // BOM     ,    firstLine
+    CsvParser(std::vector<char>&& block, char separator, std::size_t firstLine = 1);
+
+    //     :  ";", ","   , 
+    //      ,   
+    static char sniffSeparator(const char* data, std::size_t len);
+
+    //     ; false   
+    bool next();
+
+    std::size_t size() const;
+    std::string_view operator[](std::size_t index) const;
+
+    //   ,     ( 1)
+    std::size_t line() const;
+    //          
+    std::uint64_t offset() const;
+    //     (   )
+    bool terminated() const;
+    //       
+    std::string_view raw() const;
+
+    char separator() const;
+
+private:
+    struct Field {
+        std::size_t begin;
+        std::size_t length;
+        bool unescaped;
+    };
+
+    bool fill();
+    bool parseRecord(std::size_t& p);
+    std::istream* in;
+    std::vector<char> buf;
+    std::size_t pos;
+    std::size_t end;
+    bool eof;
+    bool started;
+
+    std::vector<Field> fields;
+    std::string scratch;
+
+    char sep;
+    std::uint64_t base;
+    std::size_t recordBegin;
+    std::size_t recordEnd;
+    std::size_t lineNo;
+    std::size_t nextLine;
+    bool term;
+};
+
+//       
+bool csvToDouble(std::string_view text, double& value);
@@ -19,7 +19,8 @@ public:
     DbManagerCLI(String^ dbPath)
     {
         std::string p = marshal_as<std::string>(dbPath);
-        native = new NativeDb(p);
+        // WAL   :      
+        native = new NativeDb(p, DbOptions::balanced());
     }
 
     ~DbManagerCLI()
@@ -45,6 +46,35 @@ public:
         return list;
     }
 
+    //       ; afterName == nullptr   
+    List<Tuple<String^, double, double>^>^ GetPage(String^ afterName, int limit)
+    {
+        PageKey key;
+        if (afterName != nullptr) {
+            key.valid = true;
+            key.name = marshal_as<std::string>(afterName);
+        }
+        Page page = native->getPage(key, static_cast<std::size_t>(limit));
+        List<Tuple<String^, double, double>^>^ list = gcnew List<Tuple<String^, double, double>^>();
+        for (auto& r : page.rows)
+            list->Add(Tuple::Create(marshal_as<String^>(r.name), r.basePay, r.bonusPercent));
+        return list;
+    }
+
+    // k     ,   SQLite  
+    List<Tuple<String^, double, double>^>^ GetTopByPay(int k)
+    {
+        List<Tuple<String^, double, double>^>^ list = gcnew List<Tuple<String^, double, double>^>();
+        for (auto& r : native->topByPay(static_cast<std::size_t>(k)))
+            list->Add(Tuple::Create(marshal_as<String^>(r.name), r.basePay, r.bonusPercent));
+        return list;
+    }
+
+    double AveragePay()
+    {
+        return native->payStats().average;
+    }
+
     void ClearTable()
     {
         native->clearTable();
@@ -55,11 +85,49 @@ public:
         native->insertOrReplace(marshal_as<std::string>(name), basePay, bonusPercent);
     }
 
+    //       
+    void InsertMany(List<Tuple<String^, double, double>^>^ rows)
+    {
+        std::vector<std::tuple<std::string, double, double>> vec;
+        vec.reserve(rows->Count);
+        for each (Tuple<String^, double, double>^ t in rows)
+            vec.emplace_back(marshal_as<std::string>(t->Item1), t->Item2, t->Item3);
+        native->insertMany(vec);
+    }
+
+    //    rows ,  
+    void ReplaceAll(List<Tuple<String^, double, double>^>^ rows)
+    {
+        std::vector<std::tuple<std::string, double, double>> vec;
+        vec.reserve(rows->Count);
+        for each (Tuple<String^, double, double>^ t in rows)
+            vec.emplace_back(marshal_as<std::string>(t->Item1), t->Item2, t->Item3);
+        native->replaceAll(vec);
+    }
+
     void ImportFromFile(String^ filename)
     {
         native->importFromFile(marshal_as<std::string>(filename));
     }
 
+    //    ;    
+    void SyncFromFile(String^ filename)
+    {
+        native->syncFromFile(marshal_as<std::string>(filename));
+    }
+
+    int ImportIncremental(String^ filename)
+    {
+        return static_cast<int>(native->importIncremental(marshal_as<std::string>(filename)));
+    }
+
+    //     ;   
+    String^ ValidateFile(String^ filename)
+    {
+        ValidationReport report = native->validateFile(marshal_as<std::string>(filename));
+        return marshal_as<String^>(report.text());
+    }
+
     void ExportToFile(String^ filename)
     {
         native->exportToFile(marshal_as<std::string>(filename));
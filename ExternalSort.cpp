@@ -0,0 +1,168 @@
+#include "ExternalSort.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::atomic<unsigned> sorterCounter(0);
+
+//  ,       
+std::string unique_prefix(const std::string& dir)
+{
+    std::filesystem::path base = dir.empty() ? std::filesystem::temp_directory_path() : std::filesystem::path(dir);
+#ifdef _WIN32
+    long pid = static_cast<long>(_getpid());
+#else
+    long pid = static_cast<long>(getpid());
+#endif
+    std::string name = "payroll-sort-" + std::to_string(pid) + "-" + std::to_string(++sorterCounter) + "-";
+    return (base / name).string();
+}
+
+} // namespace
+
+struct ExternalSorter::Run {
+    std::ifstream in;
+    std::vector<char> buf;
+
+    explicit Run(const std::string& filename) : buf(1 << 20)
+    {
+        in.rdbuf()->pubsetbuf(buf.data(), static_cast<std::streamsize>(buf.size()));
+        in.open(filename, std::ios::binary);
+        if (!in) throw std::runtime_error("cannot open sort run: " + filename);
+    }
+};
+
+ExternalSorter::ExternalSorter(const std::string& tempDir, std::size_t memoryLimit)
+    : tempDir(tempDir), memoryLimit(memoryLimit ? memoryLimit : (256u << 20)),
+    memoryUsed(0), bufferPos(0), finished(false) {}
+
+ExternalSorter::~ExternalSorter()
+{
+    readers.clear();
+    for (const std::string& f : runFiles) std::remove(f.c_str());
+}
+
+void ExternalSorter::add(std::string_view name, double basePay, double bonusPercent)
+{
+    if (finished) throw std::logic_error("ExternalSorter: add after finish");
+    Entry e;
+    e.name.assign(name.data(), name.size());
+    e.basePay = basePay;
+    e.bonusPercent = bonusPercent;
+    buffer.push_back(std::move(e));
+    memoryUsed += sizeof(Entry) + name.size();
+    if (memoryUsed >= memoryLimit) spill();
+}
+
+//          
+void ExternalSorter::sortBuffer()
+{
+    std::stable_sort(buffer.begin(), buffer.end(),
+        [](const Entry& a, const Entry& b) { return a.name < b.name; });
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < buffer.size(); ++i) {
+        if (i + 1 < buffer.size() && buffer[i + 1].name == buffer[i].name) continue;
+        if (out != i) buffer[out] = std::move(buffer[i]);
+        ++out;
+    }
+    buffer.resize(out);
+}
+
+void ExternalSorter::spill()
+{
+    sortBuffer();
+    if (runPrefix.empty()) runPrefix = unique_prefix(tempDir);
+    std::string filename = runPrefix + std::to_string(runFiles.size()) + ".tmp";
+    {
+        std::vector<char> buf(1 << 20);
+        std::ofstream out;
+        out.rdbuf()->pubsetbuf(buf.data(), static_cast<std::streamsize>(buf.size()));
+        out.open(filename, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("cannot create sort run: " + filename);
+        runFiles.push_back(filename);
+        for (const Entry& e : buffer) {
+            std::uint32_t len = static_cast<std::uint32_t>(e.name.size());
+            out.write(reinterpret_cast<const char*>(&len), sizeof(len));
+            out.write(e.name.data(), len);
+            out.write(reinterpret_cast<const char*>(&e.basePay), sizeof(e.basePay));
+            out.write(reinterpret_cast<const char*>(&e.bonusPercent), sizeof(e.bonusPercent));
+        }
+        out.flush();
+        if (!out) throw std::runtime_error("write failed: " + filename);
+    }
+    buffer.clear();
+    buffer.shrink_to_fit();
+    memoryUsed = 0;
+}
+
+void ExternalSorter::finish()
+{
+    if (finished) return;
+    finished = true;
+    if (runFiles.empty()) {
+        sortBuffer();
+        return;
+    }
+    if (!buffer.empty()) spill();
+
+    heads.resize(runFiles.size());
+    live.assign(runFiles.size(), false);
+    for (std::size_t i = 0; i < runFiles.size(); ++i) {
+        readers.push_back(std::unique_ptr<Run>(new Run(runFiles[i])));
+        live[i] = pull(i, heads[i]);
+    }
+}
+
+bool ExternalSorter::pull(std::size_t run, SortedRow& row)
+{
+    std::ifstream& in = readers[run]->in;
+    std::uint32_t len;
+    if (!in.read(reinterpret_cast<char*>(&len), sizeof(len))) return false;
+    row.name.resize(len);
+    in.read(&row.name[0], len);
+    in.read(reinterpret_cast<char*>(&row.basePay), sizeof(row.basePay));
+    in.read(reinterpret_cast<char*>(&row.bonusPercent), sizeof(row.bonusPercent));
+    if (!in) throw std::runtime_error("sort run is truncated");
+    return true;
+}
+
+bool ExternalSorter::next(SortedRow& row)
+{
+    if (!finished) finish();
+
+    if (readers.empty()) {
+        if (bufferPos >= buffer.size()) return false;
+        Entry& e = buffer[bufferPos++];
+        row.name.swap(e.name);
+        row.basePay = e.basePay;
+        row.bonusPercent = e.bonusPercent;
+        return true;
+    }
+
+    //   (  / memoryLimit),     
+    std::size_t best = runFiles.size();
+    for (std::size_t i = 0; i < heads.size(); ++i) {
+        if (!live[i]) continue;
+        //            
+        if (best == runFiles.size() || heads[i].name <= heads[best].name) best = i;
+    }
+    if (best == runFiles.size()) return false;
+
+    row = heads[best];
+    for (std::size_t i = 0; i < heads.size(); ++i) {
+        if (live[i] && heads[i].name == row.name) live[i] = pull(i, heads[i]);
+    }
+    return true;
+}
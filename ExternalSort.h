@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// =====      =====
+//
+//      memoryLimit ,   
+//     (). next()    
+//      BINARY- SQLite (),
+//            add().
+//     ,   .  
+//  (pid  ),       
+//     .
+
+struct SortedRow {
+    std::string name;
+    double basePay = 0.0;
+    double bonusPercent = 0.0;
+};
+
+class ExternalSorter {
+public:
+    // tempDir    ;     
+    ExternalSorter(const std::string& tempDir, std::size_t memoryLimit);
+    ~ExternalSorter();
+
+    ExternalSorter(const ExternalSorter&) = delete;
+    ExternalSorter& operator=(const ExternalSorter&) = delete;
+
+    void add(std::string_view name, double basePay, double bonusPercent);
+    //  ;     next()
+    void finish();
+    bool next(SortedRow& row);
+
+    std::size_t runs() const { return runFiles.size(); }
+
+private:
+    struct Entry {
+        std::string name;
+        double basePay;
+        double bonusPercent;
+    };
+    struct Run;
+
+    void sortBuffer();
+    void spill();
+    bool pull(std::size_t run, SortedRow& row);
+
+    std::string tempDir;
+    std::string runPrefix;      //     
+    std::size_t memoryLimit;
+    std::size_t memoryUsed;
+    std::vector<Entry> buffer;
+    std::size_t bufferPos;
+    std::vector<std::string> runFiles;
+    std::vector<std::unique_ptr<Run>> readers;
+    std::vector<SortedRow> heads;
+    std::vector<bool> live;
+    bool finished;
+};
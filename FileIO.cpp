@@ -0,0 +1,500 @@
+#include "FileIO.h"
+#include "RawFile.h"
+
+#include <cctype>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+
+#ifdef PAYROLL_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef PAYROLL_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+const std::size_t ChunkSize = 1 << 20;
+const std::size_t QueueDepth = 4;
+
+//     /   
+template <class T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity) : capacity(capacity), closed(false) {}
+
+    bool push(T&& item)
+    {
+        std::unique_lock<std::mutex> lock(m);
+        notFull.wait(lock, [this] { return closed || items.size() < capacity; });
+        if (closed) return false;
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(m);
+        notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+private:
+    std::mutex m;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    std::deque<T> items;
+    std::size_t capacity;
+    bool closed;
+};
+
+// =====  =====
+
+class Encoder {
+public:
+    explicit Encoder(RawWriter& f) : file(f) {}
+    virtual ~Encoder() {}
+    virtual void write(const char* data, std::size_t len) = 0;
+    virtual void finish() = 0;
+protected:
+    RawWriter& file;
+};
+
+class PlainEncoder : public Encoder {
+public:
+    explicit PlainEncoder(RawWriter& f) : Encoder(f) {}
+    void write(const char* data, std::size_t len) override { file.write(data, len); }
+    void finish() override {}
+};
+
+#ifdef PAYROLL_WITH_ZLIB
+class GzipEncoder : public Encoder {
+public:
+    explicit GzipEncoder(RawWriter& f) : Encoder(f), out(ChunkSize)
+    {
+        zs = z_stream();
+        // windowBits 15 + 16   gzip  zlib
+        if (deflateInit2(&zs, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            throw std::runtime_error("gzip: init failed");
+    }
+    ~GzipEncoder() override { deflateEnd(&zs); }
+
+    void write(const char* data, std::size_t len) override { run(data, len, Z_NO_FLUSH); }
+    void finish() override { run(nullptr, 0, Z_FINISH); }
+
+private:
+    void run(const char* data, std::size_t len, int flush)
+    {
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        zs.avail_in = static_cast<uInt>(len);
+        int rc;
+        do {
+            zs.next_out = reinterpret_cast<Bytef*>(out.data());
+            zs.avail_out = static_cast<uInt>(out.size());
+            rc = deflate(&zs, flush);
+            if (rc == Z_STREAM_ERROR) throw std::runtime_error("gzip: deflate failed");
+            file.write(out.data(), out.size() - zs.avail_out);
+        } while (zs.avail_out == 0 || (flush == Z_FINISH && rc != Z_STREAM_END));
+    }
+
+    z_stream zs;
+    std::vector<char> out;
+};
+#endif
+
+#ifdef PAYROLL_WITH_ZSTD
+class ZstdEncoder : public Encoder {
+public:
+    explicit ZstdEncoder(RawWriter& f) : Encoder(f), out(ZSTD_CStreamOutSize())
+    {
+        cctx = ZSTD_createCCtx();
+        if (!cctx) throw std::runtime_error("zstd: init failed");
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, 3);
+    }
+    ~ZstdEncoder() override { ZSTD_freeCCtx(cctx); }
+
+    void write(const char* data, std::size_t len) override
+    {
+        ZSTD_inBuffer in = { data, len, 0 };
+        while (in.pos < in.size) run(in, ZSTD_e_continue);
+    }
+
+    void finish() override
+    {
+        ZSTD_inBuffer in = { nullptr, 0, 0 };
+        while (run(in, ZSTD_e_end) != 0) {}
+    }
+
+private:
+    std::size_t run(ZSTD_inBuffer& in, ZSTD_EndDirective mode)
+    {
+        ZSTD_outBuffer o = { out.data(), out.size(), 0 };
+        std::size_t rc = ZSTD_compressStream2(cctx, &o, &in, mode);
+        if (ZSTD_isError(rc)) throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(rc));
+        file.write(out.data(), o.pos);
+        return rc;
+    }
+
+    ZSTD_CCtx* cctx;
+    std::vector<char> out;
+};
+#endif
+
+// =====  =====
+
+class Decoder {
+public:
+    explicit Decoder(RawReader& f) : file(f), in(ChunkSize), inPos(0), inLen(0), eof(false) {}
+    virtual ~Decoder() {}
+    //  0    
+    virtual std::size_t read(char* dst, std::size_t cap) = 0;
+protected:
+    bool refill()
+    {
+        if (eof) return false;
+        inLen = file.read(in.data(), in.size());
+        inPos = 0;
+        if (inLen == 0) eof = true;
+        return inLen != 0;
+    }
+
+    RawReader& file;
+    std::vector<char> in;
+    std::size_t inPos;
+    std::size_t inLen;
+    bool eof;
+};
+
+class PlainDecoder : public Decoder {
+public:
+    explicit PlainDecoder(RawReader& f) : Decoder(f) {}
+    std::size_t read(char* dst, std::size_t cap) override
+    {
+        return file.read(dst, cap);
+    }
+};
+
+#ifdef PAYROLL_WITH_ZLIB
+class GzipDecoder : public Decoder {
+public:
+    explicit GzipDecoder(RawReader& f) : Decoder(f), midStream(false)
+    {
+        zs = z_stream();
+        // windowBits 15 + 32   gzip/zlib
+        if (inflateInit2(&zs, 15 + 32) != Z_OK)
+            throw std::runtime_error("gzip: init failed");
+    }
+    ~GzipDecoder() override { inflateEnd(&zs); }
+
+    std::size_t read(char* dst, std::size_t cap) override
+    {
+        zs.next_out = reinterpret_cast<Bytef*>(dst);
+        zs.avail_out = static_cast<uInt>(cap);
+        while (zs.avail_out > 0) {
+            if (inPos == inLen && !refill()) {
+                if (midStream) throw std::runtime_error("gzip: unexpected end of file");
+                break;
+            }
+            zs.next_in = reinterpret_cast<Bytef*>(in.data() + inPos);
+            zs.avail_in = static_cast<uInt>(inLen - inPos);
+            int rc = inflate(&zs, Z_NO_FLUSH);
+            inPos = inLen - zs.avail_in;
+            if (rc == Z_STREAM_END) {
+                //      gzip- 
+                inflateReset(&zs);
+                midStream = false;
+            }
+            else if (rc == Z_OK || rc == Z_BUF_ERROR) {
+                midStream = true;
+            }
+            else {
+                throw std::runtime_error("gzip: corrupted data");
+            }
+        }
+        return cap - zs.avail_out;
+    }
+
+private:
+    z_stream zs;
+    bool midStream;
+};
+#endif
+
+#ifdef PAYROLL_WITH_ZSTD
+class ZstdDecoder : public Decoder {
+public:
+    explicit ZstdDecoder(RawReader& f) : Decoder(f), pending(0)
+    {
+        dctx = ZSTD_createDCtx();
+        if (!dctx) throw std::runtime_error("zstd: init failed");
+    }
+    ~ZstdDecoder() override { ZSTD_freeDCtx(dctx); }
+
+    std::size_t read(char* dst, std::size_t cap) override
+    {
+        ZSTD_outBuffer out = { dst, cap, 0 };
+        while (out.pos < out.size) {
+            if (inPos == inLen && !refill()) {
+                if (pending != 0) throw std::runtime_error("zstd: unexpected end of file");
+                break;
+            }
+            ZSTD_inBuffer zin = { in.data(), inLen, inPos };
+            pending = ZSTD_decompressStream(dctx, &out, &zin);
+            if (ZSTD_isError(pending))
+                throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(pending));
+            inPos = zin.pos;
+        }
+        return out.pos;
+    }
+
+private:
+    ZSTD_DCtx* dctx;
+    std::size_t pending;
+};
+#endif
+
+std::unique_ptr<Encoder> makeEncoder(Compression c, RawWriter& f)
+{
+    switch (c) {
+#ifdef PAYROLL_WITH_ZLIB
+    case Compression::Gzip: return std::unique_ptr<Encoder>(new GzipEncoder(f));
+#endif
+#ifdef PAYROLL_WITH_ZSTD
+    case Compression::Zstd: return std::unique_ptr<Encoder>(new ZstdEncoder(f));
+#endif
+    case Compression::None: return std::unique_ptr<Encoder>(new PlainEncoder(f));
+    default: break;
+    }
+    throw std::runtime_error("compression format is not supported by this build");
+}
+
+std::unique_ptr<Decoder> makeDecoder(Compression c, RawReader& f)
+{
+    switch (c) {
+#ifdef PAYROLL_WITH_ZLIB
+    case Compression::Gzip: return std::unique_ptr<Decoder>(new GzipDecoder(f));
+#endif
+#ifdef PAYROLL_WITH_ZSTD
+    case Compression::Zstd: return std::unique_ptr<Decoder>(new ZstdDecoder(f));
+#endif
+    case Compression::None: return std::unique_ptr<Decoder>(new PlainDecoder(f));
+    default: break;
+    }
+    throw std::runtime_error("compression format is not supported by this build");
+}
+
+bool endsWith(const std::string& s, const char* suffix)
+{
+    std::size_t n = std::char_traits<char>::length(suffix);
+    if (s.size() < n) return false;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (std::tolower(static_cast<unsigned char>(s[s.size() - n + i])) != suffix[i])
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+Compression compressionForFile(const std::string& filename)
+{
+    if (endsWith(filename, ".gz")) return Compression::Gzip;
+    if (endsWith(filename, ".zst")) return Compression::Zstd;
+    return Compression::None;
+}
+
+// ===== OutputFile =====
+
+struct OutputFile::Impl : public std::streambuf {
+    RawWriter file;
+    std::unique_ptr<Encoder> encoder;
+    BoundedQueue<std::vector<char>> queue;
+    std::thread worker;
+    std::exception_ptr error;
+    std::vector<char> buf;
+    std::ostream out;
+    bool closed;
+    std::uint64_t handedOff;
+
+    explicit Impl(const std::string& filename)
+        : file(filename), queue(QueueDepth), out(this), closed(false), handedOff(0)
+    {
+        encoder = makeEncoder(compressionForFile(filename), file);
+        out.exceptions(std::ios::badbit);
+        resetBuffer();
+        worker = std::thread(&Impl::run, this);
+    }
+
+    ~Impl() override
+    {
+        try { finish(); }
+        catch (...) {}
+    }
+
+    void run()
+    {
+        try {
+            std::vector<char> chunk;
+            while (queue.pop(chunk)) encoder->write(chunk.data(), chunk.size());
+            encoder->finish();
+            file.close();
+        }
+        catch (...) {
+            error = std::current_exception();
+            queue.close();
+        }
+    }
+
+    std::uint64_t written() const
+    {
+        return handedOff + static_cast<std::uint64_t>(pptr() - pbase());
+    }
+
+    void resetBuffer()
+    {
+        buf.resize(ChunkSize);
+        setp(buf.data(), buf.data() + buf.size());
+    }
+
+    //        
+    void handOff()
+    {
+        std::size_t used = static_cast<std::size_t>(pptr() - pbase());
+        if (used == 0) return;
+        handedOff += used;
+        buf.resize(used);
+        if (!queue.push(std::move(buf))) {
+            buf = std::vector<char>();
+            resetBuffer();
+            if (error) std::rethrow_exception(error);
+            throw std::runtime_error("output pipeline stopped");
+        }
+        buf = std::vector<char>();
+        resetBuffer();
+    }
+
+    int_type overflow(int_type ch) override
+    {
+        handOff();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    void finish()
+    {
+        if (closed) return;
+        closed = true;
+        std::exception_ptr pending;
+        try { handOff(); }
+        catch (...) { pending = std::current_exception(); }
+        queue.close();
+        if (worker.joinable()) worker.join();
+        if (error) std::rethrow_exception(error);
+        if (pending) std::rethrow_exception(pending);
+    }
+};
+
+OutputFile::OutputFile(const std::string& filename)
+    : impl(new Impl(filename)) {}
+
+OutputFile::~OutputFile() = default;
+
+std::ostream& OutputFile::stream() { return impl->out; }
+
+std::uint64_t OutputFile::bytesWritten() const
+{
+    return impl->written();
+}
+
+void OutputFile::close() { impl->finish(); }
+
+// ===== InputFile =====
+
+struct InputFile::Impl : public std::streambuf {
+    RawReader file;
+    std::unique_ptr<Decoder> decoder;
+    BoundedQueue<std::vector<char>> queue;
+    std::thread worker;
+    std::exception_ptr error;
+    std::vector<char> current;
+    std::istream in;
+    std::atomic<std::uint64_t> rawRead;
+
+    Impl(const std::string& filename, std::uint64_t startOffset)
+        : file(filename, startOffset), queue(QueueDepth), in(this), rawRead(startOffset)
+    {
+        Compression c = compressionForFile(filename);
+        if (startOffset != 0 && c != Compression::None)
+            throw std::runtime_error("cannot seek in a compressed file: " + filename);
+        decoder = makeDecoder(c, file);
+        in.exceptions(std::ios::badbit);
+        worker = std::thread(&Impl::run, this);
+    }
+
+    ~Impl() override
+    {
+        queue.close();
+        if (worker.joinable()) worker.join();
+    }
+
+    void run()
+    {
+        try {
+            for (;;) {
+                std::vector<char> chunk(ChunkSize);
+                std::size_t n = decoder->read(chunk.data(), chunk.size());
+                if (n == 0) break;
+                chunk.resize(n);
+                rawRead.store(file.position(), std::memory_order_relaxed);
+                if (!queue.push(std::move(chunk))) return;
+            }
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        queue.close();
+    }
+
+    int_type underflow() override
+    {
+        if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+        if (!queue.pop(current)) {
+            if (error) std::rethrow_exception(error);
+            return traits_type::eof();
+        }
+        setg(current.data(), current.data(), current.data() + current.size());
+        return traits_type::to_int_type(*gptr());
+    }
+};
+
+InputFile::InputFile(const std::string& filename, std::uint64_t startOffset)
+    : impl(new Impl(filename, startOffset)) {}
+
+InputFile::~InputFile() = default;
+
+std::istream& InputFile::stream() { return impl->in; }
+
+std::uint64_t InputFile::bytesRead() const { return impl->rawRead.load(std::memory_order_relaxed); }
+std::uint64_t InputFile::size() const { return impl->file.size(); }
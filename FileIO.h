@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <istream>
+#include <ostream>
+
+// =====  /     =====
+//
+//    : ".gz"  gzip, ".zst"  zstd,
+//   /  . ,   
+// / (RawFile)    ,  /
+//       .
+
+enum class Compression { None, Gzip, Zstd };
+
+Compression compressionForFile(const std::string& filename);
+
+class OutputFile {
+public:
+    explicit OutputFile(const std::string& filename);
+    ~OutputFile();
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    std::ostream& stream();
+
+    //   ( )    
+    std::uint64_t bytesWritten() const;
+
+    //  ,       
+    void close();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+class InputFile {
+public:
+    // startOffset     
+    explicit InputFile(const std::string& filename, std::uint64_t startOffset = 0);
+    ~InputFile();
+
+    InputFile(const InputFile&) = delete;
+    InputFile& operator=(const InputFile&) = delete;
+
+    std::istream& stream();
+
+    //            
+    //   ,      
+    std::uint64_t bytesRead() const;
+    std::uint64_t size() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
@@ -0,0 +1,423 @@
+#include "ImportPipeline.h"
+#include "FileIO.h"
+#include "CsvParser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const std::size_t BlockBytes = 4 << 20;
+const std::size_t QueueCapacity = 16;
+
+double secondsSince(Clock::time_point t)
+{
+    return std::chrono::duration<double>(Clock::now() - t).count();
+}
+
+//  MPMC-   ( )
+template <class T>
+class LockFreeQueue {
+public:
+    explicit LockFreeQueue(std::size_t capacity)
+        : cells(new Cell[roundUp(capacity)]), mask(roundUp(capacity) - 1), head(0), tail(0)
+    {
+        for (std::size_t i = 0; i <= mask; ++i) cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool tryPush(T& item)
+    {
+        std::size_t pos = tail.load(std::memory_order_relaxed);
+        Cell* c;
+        for (;;) {
+            c = &cells[pos & mask];
+            std::size_t seq = c->seq.load(std::memory_order_acquire);
+            std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        c->value = std::move(item);
+        c->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& item)
+    {
+        std::size_t pos = head.load(std::memory_order_relaxed);
+        Cell* c;
+        for (;;) {
+            c = &cells[pos & mask];
+            std::size_t seq = c->seq.load(std::memory_order_acquire);
+            std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+        item = std::move(c->value);
+        c->seq.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> seq;
+        T value;
+    };
+
+    static std::size_t roundUp(std::size_t n)
+    {
+        std::size_t p = 2;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    std::unique_ptr<Cell[]> cells;
+    std::size_t mask;
+    alignas(64) std::atomic<std::size_t> head;
+    alignas(64) std::atomic<std::size_t> tail;
+};
+
+//   :   ,  
+class Backoff {
+public:
+    Backoff() : spins(0) {}
+    void wait()
+    {
+        if (++spins < 64) std::this_thread::yield();
+        else std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    void reset() { spins = 0; }
+private:
+    unsigned spins;
+};
+
+struct Block {
+    std::uint64_t seq = 0;
+    std::uint64_t sourceBytes = 0;
+    std::size_t firstLine = 1;
+    std::vector<char> data;
+};
+
+struct Shared {
+    LockFreeQueue<Block> blocks;
+    LockFreeQueue<RowBatch> batches;
+    std::atomic<bool> abort;
+    std::atomic<bool> readerDone;
+    std::atomic<std::uint64_t> totalBlocks;
+    std::atomic<std::uint64_t> fileSize;
+    std::atomic<unsigned> inFlight;
+    std::atomic<char> separator;
+    std::mutex errorLock;
+    std::exception_ptr error;
+
+    Shared()
+        : blocks(QueueCapacity), batches(QueueCapacity), abort(false), readerDone(false),
+        totalBlocks(0), fileSize(0), inFlight(0), separator(0) {}
+
+    void fail()
+    {
+        std::lock_guard<std::mutex> lock(errorLock);
+        if (!error) error = std::current_exception();
+        abort.store(true);
+    }
+};
+
+//       CsvParser:      
+//  ( ),       
+enum class CsvState { FieldStart, Unquoted, Quoted, QuoteInQuoted, AfterQuote };
+
+//  ; recordEnd     
+inline CsvState csvStep(CsvState state, char c, char separator, bool& recordEnd)
+{
+    recordEnd = false;
+    switch (state) {
+    case CsvState::Quoted:
+        return c == '"' ? CsvState::QuoteInQuoted : CsvState::Quoted;
+    case CsvState::QuoteInQuoted:
+        if (c == '"') return CsvState::Quoted;   // ""  
+        state = CsvState::AfterQuote;            //  , c    
+        break;
+    case CsvState::FieldStart:
+        if (c == ' ' || (c == '\t' && separator != '\t')) return CsvState::FieldStart;
+        if (c == '"') return CsvState::Quoted;
+        state = CsvState::Unquoted;
+        break;
+    default:
+        break;
+    }
+    if (c == separator) return CsvState::FieldStart;
+    if (c == '\n') {
+        recordEnd = true;
+        return CsvState::FieldStart;
+    }
+    return state;
+}
+
+//  :          
+void readerStage(const std::string& filename, char separator, unsigned maxInFlight,
+    Shared& sh, double& busy)
+{
+    try {
+        InputFile file(filename);
+        sh.fileSize.store(file.size());
+        std::istream& in = file.stream();
+        Backoff backoff;
+
+        std::vector<char> carry;
+        CsvState state = CsvState::FieldStart;
+        bool first = true;
+        std::size_t line = 1;
+        std::size_t carryLines = 0;
+        std::uint64_t seq = 0;
+
+        for (;;) {
+            Clock::time_point t0 = Clock::now();
+            std::vector<char> data;
+            data.reserve(carry.size() + BlockBytes);
+            data.assign(carry.begin(), carry.end());
+            std::size_t scanFrom = data.size();
+            data.resize(scanFrom + BlockBytes);
+            in.read(data.data() + scanFrom, static_cast<std::streamsize>(BlockBytes));
+            std::size_t got = static_cast<std::size_t>(in.gcount());
+            data.resize(scanFrom + got);
+            bool last = got == 0;
+
+            if (first) {
+                first = false;
+                const unsigned char* u = reinterpret_cast<const unsigned char*>(data.data());
+                if (data.size() >= 3 && u[0] == 0xEF && u[1] == 0xBB && u[2] == 0xBF) {
+                    data.erase(data.begin(), data.begin() + 3);
+                    scanFrom = 0;
+                }
+                if (!separator) separator = CsvParser::sniffSeparator(data.data(), data.size());
+                sh.separator.store(separator);
+            }
+
+            std::size_t cut = 0;
+            std::size_t lines = carryLines;
+            std::size_t linesAtCut = 0;
+            if (!last) {
+                bool recordEnd;
+                for (std::size_t i = scanFrom; i < data.size(); ++i) {
+                    char c = data[i];
+                    state = csvStep(state, c, separator, recordEnd);
+                    if (c == '\n') ++lines;
+                    if (recordEnd) {
+                        cut = i + 1;
+                        linesAtCut = lines;
+                    }
+                }
+            }
+            else {
+                cut = data.size();
+                linesAtCut = lines;
+            }
+
+            if (cut == 0 && !last) {
+                //      
+                carry.swap(data);
+                carryLines = lines;
+                busy += secondsSince(t0);
+                continue;
+            }
+            carry.assign(data.begin() + cut, data.end());
+            carryLines = lines - linesAtCut;
+            data.resize(cut);
+            busy += secondsSince(t0);
+
+            if (!data.empty()) {
+                Block b;
+                b.seq = seq++;
+                b.sourceBytes = last ? file.size() : file.bytesRead();
+                b.firstLine = line;
+                b.data.swap(data);
+                line += linesAtCut;
+
+                backoff.reset();
+                while (sh.inFlight.load(std::memory_order_acquire) >= maxInFlight && !sh.abort.load())
+                    backoff.wait();
+                sh.inFlight.fetch_add(1, std::memory_order_acq_rel);
+                backoff.reset();
+                while (!sh.blocks.tryPush(b)) {
+                    if (sh.abort.load()) return;
+                    backoff.wait();
+                }
+            }
+            if (last) break;
+            if (sh.abort.load()) return;
+        }
+        sh.totalBlocks.store(seq);
+        sh.readerDone.store(true, std::memory_order_release);
+    }
+    catch (...) {
+        sh.fail();
+    }
+}
+
+void addIssue(RowBatch& batch, std::size_t line, unsigned column, ImportIssueKind kind)
+{
+    ImportIssue issue;
+    issue.line = line;
+    issue.column = column;
+    issue.kind = kind;
+    batch.issues.push_back(issue);
+}
+
+void parserStage(Shared& sh, double& busy)
+{
+    try {
+        Backoff backoff;
+        Block b;
+        for (;;) {
+            if (!sh.blocks.tryPop(b)) {
+                if (sh.abort.load()) return;
+                bool done = sh.readerDone.load(std::memory_order_acquire);
+                if (!sh.blocks.tryPop(b)) {
+                    if (done) return;
+                    backoff.wait();
+                    continue;
+                }
+            }
+            backoff.reset();
+
+            Clock::time_point t0 = Clock::now();
+            RowBatch batch;
+            batch.seq = b.seq;
+            batch.sourceBytes = b.sourceBytes;
+            CsvParser csv(std::move(b.data), sh.separator.load(), b.firstLine);
+            b.data = std::vector<char>();
+            while (csv.next()) {
+                double base, bonus;
+                if (csv.size() < 3) {
+                    ++batch.skipped;
+                    addIssue(batch, csv.line(), 0, ImportIssueKind::TooFewFields);
+                    continue;
+                }
+                //      ,  ,  
+                bool baseOk = csvToDouble(csv[1], base);
+                bool bonusOk = csvToDouble(csv[2], bonus);
+                if (!baseOk || !bonusOk) {
+                    addIssue(batch, csv.line(), baseOk ? 3 : 2, ImportIssueKind::InvalidNumber);
+                    continue;
+                }
+                batch.lines.push_back(csv.line());
+                batch.names.append(csv[0].data(), csv[0].size());
+                batch.nameEnds.push_back(static_cast<std::uint32_t>(batch.names.size()));
+                batch.basePay.push_back(base);
+                batch.bonusPercent.push_back(bonus);
+            }
+            busy += secondsSince(t0);
+
+            while (!sh.batches.tryPush(batch)) {
+                if (sh.abort.load()) return;
+                backoff.wait();
+            }
+            backoff.reset();
+        }
+    }
+    catch (...) {
+        sh.fail();
+    }
+}
+
+} // namespace
+
+void runImportPipeline(const std::string& filename, const ImportOptions& options,
+    const std::function<void(const RowBatch&)>& sink, ImportStats& stats)
+{
+    unsigned parsers = options.parserThreads;
+    if (parsers == 0) {
+        unsigned hw = std::thread::hardware_concurrency();
+        parsers = hw > 2 ? std::min(hw - 2, 8u) : 1;
+    }
+    const unsigned maxInFlight = static_cast<unsigned>(QueueCapacity) + parsers;
+
+    Shared sh;
+    Clock::time_point start = Clock::now();
+    ProgressMeter meter(options.progress, options.progressInterval, 0);
+    double readerBusy = 0.0;
+    std::vector<double> parserBusy(parsers, 0.0);
+    double writerBusy = 0.0;
+
+    std::vector<std::thread> threads;
+    threads.emplace_back(readerStage, std::cref(filename), options.separator, maxInFlight,
+        std::ref(sh), std::ref(readerBusy));
+    for (unsigned i = 0; i < parsers; ++i)
+        threads.emplace_back(parserStage, std::ref(sh), std::ref(parserBusy[i]));
+
+    // :      
+    try {
+        std::map<std::uint64_t, RowBatch> pending;
+        std::uint64_t nextSeq = 0;
+        Backoff backoff;
+        RowBatch batch;
+        for (;;) {
+            if (sh.abort.load()) break;
+            if (sh.readerDone.load(std::memory_order_acquire) && nextSeq == sh.totalBlocks.load()) break;
+
+            if (!sh.batches.tryPop(batch)) {
+                backoff.wait();
+                continue;
+            }
+            backoff.reset();
+            std::uint64_t seq = batch.seq;
+            pending.emplace(seq, std::move(batch));
+
+            for (auto it = pending.find(nextSeq); it != pending.end(); it = pending.find(nextSeq)) {
+                Clock::time_point t0 = Clock::now();
+                sink(it->second);
+                writerBusy += secondsSince(t0);
+                stats.rowsImported += it->second.size();
+                stats.rowsSkipped += it->second.skipped;
+                stats.bytesProcessed = std::max(stats.bytesProcessed, it->second.sourceBytes);
+                pending.erase(it);
+                ++nextSeq;
+                sh.inFlight.fetch_sub(1, std::memory_order_acq_rel);
+
+                if (options.cancel) options.cancel->check();
+                meter.setBytesTotal(sh.fileSize.load());
+                meter.update(stats.bytesProcessed, stats.rowsImported, stats.rowsSkipped);
+            }
+        }
+    }
+    catch (...) {
+        sh.fail();
+    }
+
+    for (std::thread& t : threads) t.join();
+    if (sh.error) std::rethrow_exception(sh.error);
+
+    ProgressInfo info = meter.finish();
+    stats.seconds = secondsSince(start);
+    stats.rowsPerSecond = info.rowsPerSecond;
+    stats.bytesPerSecond = info.bytesPerSecond;
+    if (stats.seconds > 0.0) {
+        double parserTotal = 0.0;
+        for (double b : parserBusy) parserTotal += b;
+        stats.readerUtilization = readerBusy / stats.seconds;
+        stats.parserUtilization = parserTotal / (stats.seconds * parsers);
+        stats.writerUtilization = writerBusy / stats.seconds;
+    }
+    stats.parserThreads = parsers;
+}
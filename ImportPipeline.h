@@ -0,0 +1,42 @@
+#pragma once
+
+#include "NativeDb.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// =====   =====
+//
+//         , N  
+//     ,      
+//      ,    SQLite.
+//    lock-free ,    
+//  ,        .
+
+struct RowBatch {
+    std::uint64_t seq = 0;
+    std::uint64_t sourceBytes = 0;   //        
+    std::string names;
+    std::vector<std::uint32_t> nameEnds;
+    std::vector<double> basePay;
+    std::vector<double> bonusPercent;
+    std::vector<std::size_t> lines;      //      
+    std::vector<ImportIssue> issues;     //  ,  
+    std::size_t skipped = 0;
+
+    std::size_t size() const { return basePay.size(); }
+    std::string_view name(std::size_t i) const
+    {
+        std::uint32_t begin = i ? nameEnds[i - 1] : 0;
+        return std::string_view(names.data() + begin, nameEnds[i] - begin);
+    }
+};
+
+//  sink       ; 
+//        stats.  
+//        options.
+void runImportPipeline(const std::string& filename, const ImportOptions& options,
+    const std::function<void(const RowBatch&)>& sink, ImportStats& stats);
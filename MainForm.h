@@ -283,13 +283,16 @@ private:
     {
         try
         {
-            db->ClearTable();
             const std::vector<std::shared_ptr<IWorkType>>& items = dept->getWorkTypes();
+            System::Collections::Generic::List<System::Tuple<System::String^, double, double>^>^ rows =
+                gcnew System::Collections::Generic::List<System::Tuple<System::String^, double, double>^>(
+                    static_cast<int>(items.size()));
             for (size_t i = 0; i < items.size(); ++i)
             {
                 std::shared_ptr<IWorkType> w = items[i];
-                db->Insert(ToSystemString(w->getName()), w->getBasePay(), w->getBonusPercent());
+                rows->Add(System::Tuple::Create(ToSystemString(w->getName()), w->getBasePay(), w->getBonusPercent()));
             }
+            db->ReplaceAll(rows);   //     
         }
         catch (System::Exception^ ex) { ShowError(ex->Message); }
         catch (const std::exception& ex) { ShowError(ToSystemString(ex.what())); }
@@ -391,7 +394,7 @@ private:
     void OnLoadClick(System::Object^ sender, System::EventArgs^ e)
     {
         System::Windows::Forms::OpenFileDialog^ dlg = gcnew System::Windows::Forms::OpenFileDialog();
-        dlg->Filter = "CSV/TXT (*.csv;*.txt)|*.csv;*.txt|  (*.*)|*.*";
+        dlg->Filter = "CSV/TXT (*.csv;*.txt)|*.csv;*.txt| CSV (*.csv.gz;*.csv.zst)|*.csv.gz;*.csv.zst|  (*.*)|*.*";
 
         if (dlg->ShowDialog(this) == System::Windows::Forms::DialogResult::OK)
         {
@@ -405,11 +408,10 @@ private:
 
                 if (res == System::Windows::Forms::DialogResult::Cancel) return;
 
-                if (res == System::Windows::Forms::DialogResult::Yes) {
-                    db->ClearTable(); //    
-                }
-
-                db->ImportFromFile(dlg->FileName);   //   
+                if (res == System::Windows::Forms::DialogResult::Yes)
+                    db->SyncFromFile(dlg->FileName);     // :   
+                else
+                    db->ImportFromFile(dlg->FileName);   //   
                 LoadFromDatabaseToDept();            //    
 
                 System::Windows::Forms::MessageBox::Show(" .", "",
@@ -426,7 +428,7 @@ private:
     void OnSaveClick(System::Object^ sender, System::EventArgs^ e)
     {
         System::Windows::Forms::SaveFileDialog^ dlg = gcnew System::Windows::Forms::SaveFileDialog();
-        dlg->Filter = "CSV (comma separated) (*.csv)|*.csv|  (*.txt)|*.txt|  (*.*)|*.*";
+        dlg->Filter = "CSV (comma separated) (*.csv)|*.csv|CSV, gzip (*.csv.gz)|*.csv.gz|CSV, zstd (*.csv.zst)|*.csv.zst|Apache Arrow (*.arrow)|*.arrow|  (*.txt)|*.txt|  (*.*)|*.*";
         dlg->DefaultExt = "csv";
         dlg->AddExtension = true;
         dlg->OverwritePrompt = true;
@@ -1,25 +1,622 @@
 #include "NativeDb.h"
 #include "sqlite3.h"
+#include "FileIO.h"
+#include "CsvParser.h"
+#include "ImportPipeline.h"
+#include "ArrowIpc.h"
+#include "ContentHash.h"
+#include "ExternalSort.h"
 #include <fstream>
-#include <sstream>
+#include <cstdio>
+#include <unordered_map>
+#include <cstdint>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <stdexcept>
 #include <iostream>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <sstream>
+#include <locale>
+
+// ===== DbOptions =====
+
+DbOptions DbOptions::durable()
+{
+    DbOptions o;
+    o.journalMode = JournalMode::Delete;
+    o.synchronous = SyncLevel::Full;
+    o.busyTimeoutMs = 5000;
+    return o;
+}
+
+DbOptions DbOptions::balanced()
+{
+    DbOptions o;
+    o.journalMode = JournalMode::Wal;
+    o.synchronous = SyncLevel::Normal;
+    o.mmapSize = 256LL << 20;
+    o.cacheSizeKiB = 64 << 10;
+    o.tempStore = TempStore::Memory;
+    o.busyTimeoutMs = 5000;
+    o.readerConnections = 4;
+    return o;
+}
+
+DbOptions DbOptions::bulkLoad()
+{
+    DbOptions o;
+    o.journalMode = JournalMode::Memory;
+    o.synchronous = SyncLevel::Off;
+    o.mmapSize = 256LL << 20;
+    o.cacheSizeKiB = 256 << 10;
+    o.pageSize = 16384;
+    o.tempStore = TempStore::Memory;
+    o.busyTimeoutMs = 5000;
+    return o;
+}
+
+static void exec_sql(sqlite3* db, const char* sql)
+{
+    char* err = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &err) != SQLITE_OK) {
+        std::string msg = "SQL error: ";
+        if (err) { msg += err; sqlite3_free(err); }
+        throw std::runtime_error(msg);
+    }
+}
+
+static void exec_sql(sqlite3* db, const std::string& sql)
+{
+    exec_sql(db, sql.c_str());
+}
+
+static const char* const SyncNames[] = { nullptr, "OFF", "NORMAL", "FULL", "EXTRA" };
+
+static std::int64_t query_pragma(sqlite3* db, const char* sql)
+{
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error("prepare failed");
+    std::int64_t value = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) value = sqlite3_column_int64(stmt, 0);
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+static std::string query_text(sqlite3* db, const char* sql)
+{
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error("prepare failed");
+    std::string value;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const unsigned char* text = sqlite3_column_text(stmt, 0);
+        if (text) value = reinterpret_cast<const char*>(text);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+
+//  ,       
+struct Statement {
+    sqlite3_stmt* stmt;
+    Statement(sqlite3* db, const char* sql) : stmt(nullptr)
+    {
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+            throw std::runtime_error("prepare failed");
+    }
+    ~Statement() { sqlite3_finalize(stmt); }
+    Statement(const Statement&) = delete;
+    Statement& operator=(const Statement&) = delete;
+};
+
+static void step_done(sqlite3_stmt* stmt, const char* what)
+{
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (rc != SQLITE_DONE) throw std::runtime_error(what);
+}
+
+// =====  =====
+
+struct NativeDb::ConnectionPool {
+    std::recursive_mutex writer;      //     
+    std::mutex lock;
+    std::condition_variable available;
+    std::vector<sqlite3*> idle;
+    std::vector<sqlite3*> all;
+    unsigned limit = 0;               // 0     
+};
+
+//       .   
+// ,        ;  WAL
+//        .
+class NativeDb::ReadLease {
+public:
+    explicit ReadLease(NativeDb& db) : db(db), conn(nullptr)
+    {
+        ConnectionPool& pool = *db.pool;
+        if (pool.limit == 0) {
+            writerLock = std::unique_lock<std::recursive_mutex>(pool.writer);
+            conn = db.dbHandle;
+            return;
+        }
+        {
+            std::unique_lock<std::mutex> lock(pool.lock);
+            while (pool.idle.empty() && pool.all.size() >= pool.limit) pool.available.wait(lock);
+            if (!pool.idle.empty()) {
+                conn = pool.idle.back();
+                pool.idle.pop_back();
+            }
+            else {
+                conn = db.openReader();
+                pool.all.push_back(conn);
+            }
+        }
+        if (sqlite3_exec(conn, "BEGIN;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            release();
+            throw std::runtime_error("cannot start read transaction");
+        }
+    }
+
+    ~ReadLease()
+    {
+        if (writerLock.owns_lock()) return;
+        sqlite3_exec(conn, "COMMIT;", nullptr, nullptr, nullptr);
+        release();
+    }
+
+    ReadLease(const ReadLease&) = delete;
+    ReadLease& operator=(const ReadLease&) = delete;
+
+    sqlite3* handle() const { return conn; }
+
+private:
+    void release()
+    {
+        ConnectionPool& pool = *db.pool;
+        {
+            std::lock_guard<std::mutex> lock(pool.lock);
+            pool.idle.push_back(conn);
+        }
+        pool.available.notify_one();
+    }
+
+    NativeDb& db;
+    sqlite3* conn;
+    std::unique_lock<std::recursive_mutex> writerLock;
+};
+
+// =====   =====
+
+struct WriteTicket::State {
+    std::mutex lock;
+    std::condition_variable doneSignal;
+    bool done = false;
+    std::string error;
+
+    void complete(const std::string& message)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            done = true;
+            error = message;
+        }
+        doneSignal.notify_all();
+    }
+};
+
+WriteTicket::WriteTicket() {}
+
+bool WriteTicket::ready() const
+{
+    if (!state) return true;
+    std::lock_guard<std::mutex> guard(state->lock);
+    return state->done;
+}
+
+void WriteTicket::wait() const
+{
+    if (!state) return;
+    std::unique_lock<std::mutex> guard(state->lock);
+    state->doneSignal.wait(guard, [&] { return state->done; });
+    if (!state->error.empty()) throw std::runtime_error(state->error);
+}
+
+struct QueuedWrite {
+    std::string name;
+    double basePay;
+    double bonusPercent;
+    std::shared_ptr<WriteTicket::State> ticket;
+};
+
+struct NativeDb::WriteQueue {
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable drained;
+    std::vector<QueuedWrite> pending;
+    std::chrono::steady_clock::time_point firstQueued;   //   
+    bool busy = false;
+    bool stop = false;
+    std::thread worker;
+};
+
+// =====   changeset =====
+
+#if defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+#define NATIVEDB_SESSIONS 1
+#endif
+
+static const char* const NoSessionsMessage =
+    "changesets need SQLite built with SQLITE_ENABLE_SESSION and SQLITE_ENABLE_PREUPDATE_HOOK";
+
+#ifdef NATIVEDB_SESSIONS
+static const char* const GeneratedColumnMessage =
+    "this SQLite session extension cannot track WorkTypes (generated column FinalPay)";
+
+//    (3.40   )     
+// ,      changeset   , 
+//   .       WorkTypes
+//      :    changeset
+static void probe_session(sqlite3* db)
+{
+    std::string ddl = query_text(db, "SELECT sql FROM sqlite_master WHERE type = 'table' AND name = 'WorkTypes';");
+    sqlite3* scratch = nullptr;
+    if (sqlite3_open(":memory:", &scratch) != SQLITE_OK) {
+        sqlite3_close(scratch);
+        throw std::runtime_error("cannot open session probe");
+    }
+    sqlite3_session* session = nullptr;
+    int rc = sqlite3_exec(scratch, ddl.c_str(), nullptr, nullptr, nullptr);
+    if (rc == SQLITE_OK) rc = sqlite3session_create(scratch, "main", &session);
+    if (rc == SQLITE_OK) rc = sqlite3session_attach(session, "WorkTypes");
+    if (rc == SQLITE_OK)
+        rc = sqlite3_exec(scratch, "INSERT INTO WorkTypes (Name, BasePay, BonusPercent) VALUES ('probe', 1, 0);",
+            nullptr, nullptr, nullptr);
+    if (rc == SQLITE_OK) {
+        int size = 0;
+        void* data = nullptr;
+        rc = sqlite3session_changeset(session, &size, &data);
+        sqlite3_free(data);
+    }
+    if (session) sqlite3session_delete(session);
+    sqlite3_close(scratch);
+    if (rc == SQLITE_SCHEMA) throw std::runtime_error(GeneratedColumnMessage);
+    if (rc != SQLITE_OK) throw std::runtime_error("session probe failed");
+}
+
+static sqlite3_session* create_session(sqlite3* db)
+{
+    sqlite3_session* session = nullptr;
+    if (sqlite3session_create(db, "main", &session) != SQLITE_OK)
+        throw std::runtime_error("cannot create session");
+    //   (ImportState, ImportedFiles,  )  
+    if (sqlite3session_attach(session, "WorkTypes") != SQLITE_OK) {
+        sqlite3session_delete(session);
+        throw std::runtime_error("cannot attach session");
+    }
+    return session;
+}
+#endif
+
+struct NativeDb::ChangeTracker {
+#ifdef NATIVEDB_SESSIONS
+    explicit ChangeTracker(sqlite3* db) : session(nullptr)
+    {
+        probe_session(db);
+        session = create_session(db);
+    }
+    ~ChangeTracker() { sqlite3session_delete(session); }
+    sqlite3_session* session;
+#else
+    explicit ChangeTracker(sqlite3*) { throw std::runtime_error(NoSessionsMessage); }
+#endif
+};
+
+// =====    =====
+
+struct BackupJob::State {
+    std::string path;
+    BackupOptions options;
+    CancellationToken cancel;
+
+    std::mutex lock;
+    std::condition_variable doneSignal;
+    bool done = false;
+    std::exception_ptr error;
+    BackupStats stats;
+
+    void complete(const BackupStats& result, std::exception_ptr failure)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stats = result;
+            error = failure;
+            done = true;
+        }
+        doneSignal.notify_all();
+    }
+};
+
+BackupJob::BackupJob() {}
+
+bool BackupJob::ready() const
+{
+    if (!state) return true;
+    std::lock_guard<std::mutex> guard(state->lock);
+    return state->done;
+}
+
+BackupStats BackupJob::wait() const
+{
+    if (!state) return BackupStats();
+    std::unique_lock<std::mutex> guard(state->lock);
+    state->doneSignal.wait(guard, [&] { return state->done; });
+    if (state->error) std::rethrow_exception(state->error);
+    return state->stats;
+}
+
+void BackupJob::cancel()
+{
+    if (state) state->cancel.cancel();
+}
+
+struct NativeDb::BackupRunner {
+    std::mutex lock;
+    std::vector<std::thread> threads;
+    std::vector<std::shared_ptr<BackupJob::State>> jobs;
+};
+
+//      . saved  sqlite3_total_changes64  
+//  :    
+struct NativeDb::Checkpointer {
+    std::mutex running;            //    
+    sqlite3_int64 saved = 0;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stop = false;
+    std::thread timer;
+};
+
+// =====  =====
+
+//  : 8    ,    1/16
+static const int SubBuckets = 8;
+static const int LatencyBuckets = 64 * SubBuckets;
+
+static int latency_bucket(std::uint64_t ns)
+{
+    int shift = 0;
+    while ((ns >> shift) >= 2 * SubBuckets) ++shift;
+    return shift * SubBuckets + static_cast<int>(ns >> shift);
+}
+
+//    
+static double bucket_middle(int bucket)
+{
+    if (bucket < 2 * SubBuckets) return bucket;
+    int shift = bucket / SubBuckets - 1;
+    double low = static_cast<double>(static_cast<std::uint64_t>(bucket % SubBuckets + SubBuckets) << shift);
+    return low + static_cast<double>(std::uint64_t(1) << shift) / 2;
+}
+
+struct NativeDb::Profiler {
+    struct Entry {
+        std::string sql;
+        std::size_t calls = 0;
+        std::size_t rows = 0;
+        std::uint64_t totalNs = 0;
+        std::uint64_t maxNs = 0;
+        std::vector<std::uint32_t> latency = std::vector<std::uint32_t>(LatencyBuckets);
+        bool planned = false;
+        std::vector<std::string> plan;
+        bool fullScan = false;
+    };
+    // ,    .    
+    //   ,       
+    struct Running {
+        sqlite3_stmt* stmt;
+        std::chrono::steady_clock::time_point start;
+        std::size_t rows;
+    };
+    struct Connection {
+        Profiler* profiler;
+        std::vector<Running> running;
+    };
+
+    std::mutex lock;
+    //   string_view  Entry::sql:    
+    std::unordered_map<std::string_view, std::unique_ptr<Entry>> entries;
+    std::vector<std::unique_ptr<Connection>> connections;
+    std::chrono::steady_clock::time_point since = std::chrono::steady_clock::now();
+
+    std::mutex dumpLock;
+    std::condition_variable wake;
+    bool stop = false;
+    std::thread timer;
+
+    void attach(sqlite3* db);
+    void record(std::string_view sql, std::uint64_t ns, std::size_t rows);
+    static int trace(unsigned type, void* context, void* p, void* x);
+};
+
+//    : SQLite    VFS,   
+//   . ROW     
+// ( ), PROFILE    EXPLAIN;     ,    STMT
+int NativeDb::Profiler::trace(unsigned type, void* context, void* p, void* x)
+{
+    Connection& c = *static_cast<Connection*>(context);
+    sqlite3_stmt* stmt = static_cast<sqlite3_stmt*>(p);
+    auto it = c.running.begin();
+    while (it != c.running.end() && it->stmt != stmt) ++it;
+
+    if (type == SQLITE_TRACE_STMT) {
+        // "-- ..."       
+        const char* text = static_cast<const char*>(x);
+        if (text && text[0] == '-' && text[1] == '-') return 0;
+        Running r = { stmt, std::chrono::steady_clock::now(), 0 };
+        if (it == c.running.end()) c.running.push_back(r);
+        else *it = r;
+        return 0;
+    }
+    if (it == c.running.end()) return 0;
+    if (type == SQLITE_TRACE_ROW) {
+        ++it->rows;
+        return 0;
+    }
+    std::uint64_t ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - it->start).count());
+    std::size_t rows = it->rows;
+    *it = c.running.back();
+    c.running.pop_back();
+    const char* sql = sqlite3_sql(stmt);
+    if (sql) c.profiler->record(sql, ns, rows);
+    return 0;
+}
+
+void NativeDb::Profiler::attach(sqlite3* db)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    connections.push_back(std::unique_ptr<Connection>(new Connection{ this, {} }));
+    sqlite3_trace_v2(db, SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW, trace, connections.back().get());
+}
+
+void NativeDb::Profiler::record(std::string_view sql, std::uint64_t ns, std::size_t rows)
+{
+    //  EXPLAIN  stats()    
+    if (sql.compare(0, 8, "EXPLAIN ") == 0) return;
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = entries.find(sql);
+    if (it == entries.end()) {
+        std::unique_ptr<Entry> e(new Entry());
+        e->sql.assign(sql.data(), sql.size());
+        std::string_view key = e->sql;
+        it = entries.emplace(key, std::move(e)).first;
+    }
+    Entry& e = *it->second;
+    ++e.calls;
+    e.rows += rows;
+    e.totalNs += ns;
+    if (ns > e.maxNs) e.maxNs = ns;
+    ++e.latency[latency_bucket(ns)];
+}
+
+static double percentile_ms(const std::vector<std::uint32_t>& latency, std::size_t calls, double p, std::uint64_t maxNs)
+{
+    std::size_t target = static_cast<std::size_t>(p * static_cast<double>(calls));
+    if (target < 1) target = 1;
+    std::size_t seen = 0;
+    for (int i = 0; i < LatencyBuckets; ++i) {
+        seen += latency[i];
+        if (seen >= target) return std::min(bucket_middle(i), static_cast<double>(maxNs)) / 1e6;
+    }
+    return static_cast<double>(maxNs) / 1e6;
+}
+
+// SCAN  USING     .   , ,
+//   (pragma_*)   sqlite_*    
+static bool is_full_scan(const std::string& detail)
+{
+    if (detail.compare(0, 5, "SCAN ") != 0 || detail.compare(0, 12, "SCAN sqlite_") == 0) return false;
+    return detail.find(" USING ") == std::string::npos
+        && detail.find("VIRTUAL TABLE") == std::string::npos
+        && detail.find("CONSTANT ROW") == std::string::npos;
+}
+
+static void explain(sqlite3* db, const std::string& sql, std::vector<std::string>& plan, bool& fullScan)
+{
+    std::unique_ptr<Statement> stmt;
+    try {
+        stmt.reset(new Statement(db, ("EXPLAIN QUERY PLAN " + sql).c_str()));
+    }
+    catch (const std::runtime_error&) {
+        // ,    ,   
+        plan.push_back(std::string("unavailable: ") + sqlite3_errmsg(db));
+        return;
+    }
+    std::unordered_map<int, int> depth;
+    while (sqlite3_step(stmt->stmt) == SQLITE_ROW) {
+        int id = sqlite3_column_int(stmt->stmt, 0);
+        auto parent = depth.find(sqlite3_column_int(stmt->stmt, 1));
+        int level = parent == depth.end() ? 0 : parent->second + 1;
+        depth[id] = level;
+        const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt->stmt, 3));
+        std::string detail = text ? text : "";
+        if (is_full_scan(detail)) fullScan = true;
+        plan.push_back(std::string(2 * level, ' ') + detail);
+    }
+}
 
-NativeDb::NativeDb(const std::string& dbPath)
-    : path(dbPath), dbHandle(nullptr)
+NativeDb::NativeDb(const std::string& dbPath, const DbOptions& options)
+    : path(dbPath), options(options), dbHandle(nullptr), pool(new ConnectionPool()),
+    writeQueue(new WriteQueue()), backups(new BackupRunner()), checkpointer(new Checkpointer()),
+    profiler(options.profile ? new Profiler() : nullptr), bulkDepth(0),
+    savedSynchronous(0), savedCacheSize(0), savedTempStore(0)
 {
     openDb();
+    //     ;     
+    checkpointer->saved = sqlite3_total_changes64(dbHandle);
     initialize();
+    if (options.recordChanges) {
+        try {
+            changes.reset(new ChangeTracker(dbHandle));
+        }
+        catch (...) {
+            closeDb();
+            throw;
+        }
+    }
+    if (options.inMemory && options.checkpointIntervalMs)
+        checkpointer->timer = std::thread(&NativeDb::runCheckpoints, this);
+    if (profiler && !options.statsDumpPath.empty() && options.statsDumpIntervalMs)
+        profiler->timer = std::thread(&NativeDb::runStatsDump, this);
 }
 
 NativeDb::~NativeDb()
 {
+    stopWriteQueue();   //     
+    stopCheckpoints();  //        
+    stopBackups();
+    stopStatsDump();    //      
+    changes.reset();    //    
     closeDb();
 }
 
+//        ;     
+static void load_from_disk(sqlite3* memory, const std::string& filename)
+{
+    sqlite3* disk = nullptr;
+    if (sqlite3_open_v2(filename.c_str(), &disk, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        sqlite3_close(disk);
+        return;
+    }
+    try {
+        //          
+        std::int64_t pageSize = query_pragma(disk, "PRAGMA page_size;");
+        exec_sql(memory, "PRAGMA page_size = " + std::to_string(pageSize) + ";");
+        sqlite3_backup* backup = sqlite3_backup_init(memory, "main", disk, "main");
+        if (!backup) throw std::runtime_error(std::string("cannot load database: ") + sqlite3_errmsg(memory));
+        sqlite3_backup_step(backup, -1);
+        if (sqlite3_backup_finish(backup) != SQLITE_OK)
+            throw std::runtime_error(std::string("cannot load database: ") + sqlite3_errmsg(memory));
+    }
+    catch (...) {
+        sqlite3_close(disk);
+        throw;
+    }
+    sqlite3_close(disk);
+}
+
 void NativeDb::openDb()
 {
-    int rc = sqlite3_open(path.c_str(), &dbHandle);
+    int rc = sqlite3_open(options.inMemory ? ":memory:" : path.c_str(), &dbHandle);
     if (rc != SQLITE_OK) {
         std::string msg = "Cannot open DB: ";
         msg += sqlite3_errmsg(dbHandle);
@@ -27,137 +624,2054 @@ void NativeDb::openDb()
         dbHandle = nullptr;
         throw std::runtime_error(msg);
     }
+    if (profiler) profiler->attach(dbHandle);
     sqlite3_exec(dbHandle, "PRAGMA foreign_keys = ON;", nullptr, nullptr, nullptr);
-}
 
-void NativeDb::closeDb()
-{
-    if (dbHandle) {
-        sqlite3_close(dbHandle);
-        dbHandle = nullptr;
+    try {
+        if (options.busyTimeoutMs > 0) sqlite3_busy_timeout(dbHandle, options.busyTimeoutMs);
+        if (options.inMemory) load_from_disk(dbHandle, path);
+        // page_size    :  WAL     
+        if (options.pageSize > 0)
+            exec_sql(dbHandle, "PRAGMA page_size = " + std::to_string(options.pageSize) + ";");
+        static const char* journal[] = { nullptr, "delete", "truncate", "persist", "memory", "wal", "off" };
+        JournalMode mode = options.journalMode;
+        if (mode == JournalMode::Default && options.readerConnections > 0) mode = JournalMode::Wal;
+        if (mode != JournalMode::Default) {
+            // PRAGMA    ,   ,  :
+            // WAL  , ,        -wal
+            std::string actual = query_text(dbHandle,
+                (std::string("PRAGMA journal_mode = ") + journal[static_cast<int>(mode)] + ";").c_str());
+            //              
+            const char* file = sqlite3_db_filename(dbHandle, "main");
+            bool onDisk = file && *file;
+            if (actual != journal[static_cast<int>(mode)] && onDisk && options.journalMode != JournalMode::Default)
+                throw std::runtime_error(std::string("cannot set journal_mode = ") + journal[static_cast<int>(mode)]
+                    + " (database stays in " + actual + ")");
+            if (options.readerConnections > 0 && actual == "wal")
+                pool->limit = options.readerConnections;
+        }
+        if (options.synchronous != SyncLevel::Default)
+            exec_sql(dbHandle, std::string("PRAGMA synchronous = ")
+                + SyncNames[static_cast<int>(options.synchronous)] + ";");
+        if (options.cacheSizeKiB > 0)
+            exec_sql(dbHandle, "PRAGMA cache_size = -" + std::to_string(options.cacheSizeKiB) + ";");
+        if (options.mmapSize >= 0)
+            exec_sql(dbHandle, "PRAGMA mmap_size = " + std::to_string(options.mmapSize) + ";");
+        static const char* temp[] = { nullptr, "FILE", "MEMORY" };
+        if (options.tempStore != TempStore::Default)
+            exec_sql(dbHandle, std::string("PRAGMA temp_store = ")
+                + temp[static_cast<int>(options.tempStore)] + ";");
+    }
+    catch (...) {
+        closeDb();
+        throw;
     }
 }
 
-void NativeDb::initialize()
+sqlite3* NativeDb::openReader()
 {
-    const char* sql =
-        "CREATE TABLE IF NOT EXISTS WorkTypes ("
-        "Id INTEGER PRIMARY KEY AUTOINCREMENT, "
-        "Name TEXT UNIQUE NOT NULL, "
-        "BasePay REAL NOT NULL, "
-        "BonusPercent REAL NOT NULL"
-        ");";
-    char* err = nullptr;
-    int rc = sqlite3_exec(dbHandle, sql, nullptr, nullptr, &err);
+    sqlite3* conn = nullptr;
+    int rc = sqlite3_open_v2(path.c_str(), &conn, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr);
     if (rc != SQLITE_OK) {
-        std::string msg = "SQL error: ";
-        if (err) { msg += err; sqlite3_free(err); }
+        std::string msg = "Cannot open DB: ";
+        msg += sqlite3_errmsg(conn);
+        sqlite3_close(conn);
         throw std::runtime_error(msg);
     }
+    if (profiler) profiler->attach(conn);
+    if (options.busyTimeoutMs > 0) sqlite3_busy_timeout(conn, options.busyTimeoutMs);
+    if (options.cacheSizeKiB > 0)
+        sqlite3_exec(conn, ("PRAGMA cache_size = -" + std::to_string(options.cacheSizeKiB) + ";").c_str(),
+            nullptr, nullptr, nullptr);
+    if (options.mmapSize >= 0)
+        sqlite3_exec(conn, ("PRAGMA mmap_size = " + std::to_string(options.mmapSize) + ";").c_str(),
+            nullptr, nullptr, nullptr);
+    if (options.tempStore == TempStore::Memory)
+        sqlite3_exec(conn, "PRAGMA temp_store = MEMORY;", nullptr, nullptr, nullptr);
+    return conn;
 }
 
-std::vector<std::tuple<std::string, double, double>> NativeDb::getAll()
+void NativeDb::beginBulkLoad()
 {
-    std::vector<std::tuple<std::string, double, double>> out;
-    const char* sql = "SELECT Name, BasePay, BonusPercent FROM WorkTypes ORDER BY Name;";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(dbHandle, sql, -1, &stmt, nullptr) != SQLITE_OK)
-        throw std::runtime_error("prepare failed");
+    std::lock_guard<std::recursive_mutex> lock(pool->writer);
+    if (bulkDepth++ > 0) return;
+    savedSynchronous = static_cast<int>(query_pragma(dbHandle, "PRAGMA synchronous;"));
+    savedCacheSize = query_pragma(dbHandle, "PRAGMA cache_size;");
+    savedTempStore = static_cast<int>(query_pragma(dbHandle, "PRAGMA temp_store;"));
+    exec_sql(dbHandle, "PRAGMA synchronous = OFF; PRAGMA temp_store = MEMORY;");
+    //   :     ,    
+    std::int64_t pageSize = query_pragma(dbHandle, "PRAGMA page_size;");
+    std::int64_t currentKiB = savedCacheSize < 0 ? -savedCacheSize : savedCacheSize * pageSize / 1024;
+    if (currentKiB < (256 << 10)) exec_sql(dbHandle, "PRAGMA cache_size = -262144;");
+}
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        const unsigned char* text = sqlite3_column_text(stmt, 0);
-        double base = sqlite3_column_double(stmt, 1);
-        double bonus = sqlite3_column_double(stmt, 2);
-        std::string name = text ? reinterpret_cast<const char*>(text) : std::string();
-        out.emplace_back(name, base, bonus);
-    }
-    sqlite3_finalize(stmt);
-    return out;
+void NativeDb::endBulkLoad()
+{
+    std::lock_guard<std::recursive_mutex> lock(pool->writer);
+    if (bulkDepth == 0 || --bulkDepth > 0) return;
+    exec_sql(dbHandle, "PRAGMA synchronous = " + std::to_string(savedSynchronous) + ";"
+        + " PRAGMA cache_size = " + std::to_string(savedCacheSize) + ";"
+        + " PRAGMA temp_store = " + std::to_string(savedTempStore) + ";");
 }
 
-void NativeDb::clearTable()
+//  bulk-    ,   
+class BulkLoadGuard {
+public:
+    BulkLoadGuard(NativeDb& db, bool enabled) : db(db), enabled(enabled)
+    {
+        if (enabled) db.beginBulkLoad();
+    }
+    ~BulkLoadGuard()
+    {
+        if (!enabled) return;
+        try { db.endBulkLoad(); }
+        catch (...) {}
+    }
+    BulkLoadGuard(const BulkLoadGuard&) = delete;
+    BulkLoadGuard& operator=(const BulkLoadGuard&) = delete;
+private:
+    NativeDb& db;
+    bool enabled;
+};
+
+//     ImportedFiles ,  DELETE  
+// ;   TR_WorkTypes_Forget*   
+// ,      
+class TriggersOff {
+public:
+    explicit TriggersOff(sqlite3* db) : db(db), previous(1)
+    {
+        sqlite3_db_config(db, SQLITE_DBCONFIG_ENABLE_TRIGGER, -1, &previous);
+        sqlite3_db_config(db, SQLITE_DBCONFIG_ENABLE_TRIGGER, 0, nullptr);
+    }
+    ~TriggersOff()
+    {
+        //    ,  
+        sqlite3_db_config(db, SQLITE_DBCONFIG_ENABLE_TRIGGER, previous, nullptr);
+    }
+    TriggersOff(const TriggersOff&) = delete;
+    TriggersOff& operator=(const TriggersOff&) = delete;
+private:
+    sqlite3* db;
+    int previous;
+};
+
+void NativeDb::closeDb()
 {
-    const char* sql = "DELETE FROM WorkTypes;";
-    char* err = nullptr;
-    int rc = sqlite3_exec(dbHandle, sql, nullptr, nullptr, &err);
-    if (rc != SQLITE_OK) {
-        std::string msg = "SQL error: ";
-        if (err) { msg += err; sqlite3_free(err); }
-        throw std::runtime_error(msg);
+    {
+        std::lock_guard<std::mutex> lock(pool->lock);
+        for (sqlite3* conn : pool->all) sqlite3_close(conn);
+        pool->all.clear();
+        pool->idle.clear();
+    }
+    if (dbHandle) {
+        sqlite3_close(dbHandle);
+        dbHandle = nullptr;
     }
 }
 
-void NativeDb::insertOrReplace(const std::string& name, double basePay, double bonusPercent)
-{
-    const char* sql = "INSERT OR REPLACE INTO WorkTypes (Name, BasePay, BonusPercent) VALUES (?, ?, ?);";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(dbHandle, sql, -1, &stmt, nullptr) != SQLITE_OK)
-        throw std::runtime_error("prepare failed");
+//     PercentageBonusStrategy,    
+#define WORKTYPES_COLUMNS \
+    "Id INTEGER PRIMARY KEY AUTOINCREMENT, " \
+    "Name TEXT UNIQUE NOT NULL, " \
+    "BasePay REAL NOT NULL, " \
+    "BonusPercent REAL NOT NULL, " \
+    "FinalPay REAL GENERATED ALWAYS AS (BasePay * (1.0 + BonusPercent / 100.0)) STORED"
 
-    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_double(stmt, 2, basePay);
-    sqlite3_bind_double(stmt, 3, bonusPercent);
+static bool has_column(sqlite3* db, const char* table, const char* column)
+{
+    std::string sql = std::string("SELECT 1 FROM pragma_table_xinfo('") + table + "') WHERE name = ?;";
+    Statement q(db, sql.c_str());
+    sqlite3_bind_text(q.stmt, 1, column, -1, SQLITE_STATIC);
+    return sqlite3_step(q.stmt) == SQLITE_ROW;
+}
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        throw std::runtime_error("insert failed");
-    }
-    sqlite3_finalize(stmt);
+static bool has_table(sqlite3* db, const char* name)
+{
+    Statement q(db, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?;");
+    sqlite3_bind_text(q.stmt, 1, name, -1, SQLITE_STATIC);
+    return sqlite3_step(q.stmt) == SQLITE_ROW;
 }
 
-static std::string trim_str(const std::string& s) {
-    size_t a = s.find_first_not_of(" \t\r\n");
-    if (a == std::string::npos) return "";
-    size_t b = s.find_last_not_of(" \t\r\n");
-    return s.substr(a, b - a + 1);
+// =====   =====
+//
+//     PRAGMA user_version.    
+//     (  , 
+//  MigrationState,      )  
+// ,        user_version.
+
+static void migrate_base_schema(sqlite3* db)
+{
+    // IF NOT EXISTS: ,    user_version,    
+    exec_sql(db,
+        "CREATE TABLE IF NOT EXISTS WorkTypes ("
+        "Id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "Name TEXT UNIQUE NOT NULL, "
+        "BasePay REAL NOT NULL, "
+        "BonusPercent REAL NOT NULL"
+        ");"
+        "CREATE TABLE IF NOT EXISTS ImportState ("
+        "Source TEXT PRIMARY KEY, "
+        "ByteOffset INTEGER NOT NULL, "
+        "LastLineLength INTEGER NOT NULL, "
+        "Fingerprint INTEGER NOT NULL"
+        ");"
+        "CREATE TABLE IF NOT EXISTS ImportedFiles ("
+        "Source TEXT PRIMARY KEY, "
+        "FileSize INTEGER NOT NULL, "
+        "ModifiedTime INTEGER NOT NULL, "
+        "ContentHash INTEGER NOT NULL"
+        ");");
 }
 
-void NativeDb::importFromFile(const std::string& filename)
+// STORED-    ALTER TABLE:   
+// WorkTypes_new   Id.   ,    
+//    ,      .
+static void copy_work_types(sqlite3* db, const MigrationOptions& options, MigrationResult& result)
 {
-    std::ifstream in(filename);
-    if (!in) throw std::runtime_error("cannot open file");
+    if (has_column(db, "WorkTypes", "FinalPay")) return;
 
-    sqlite3_exec(dbHandle, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
+    exec_sql(db, "BEGIN IMMEDIATE;");
     try {
-        std::string line;
-        while (std::getline(in, line)) {
-            line = trim_str(line);
-            if (line.empty()) continue;
-            std::istringstream iss(line);
-            std::string name, baseStr, bonusStr;
-            if (!std::getline(iss, name, ';') ||
-                !std::getline(iss, baseStr, ';') ||
-                !std::getline(iss, bonusStr))
-            {
-                continue;
-            }
-            name = trim_str(name);
-            double base = std::stod(trim_str(baseStr));
-            double bonus = std::stod(trim_str(bonusStr));
-            insertOrReplace(name, base, bonus);
-        }
-        sqlite3_exec(dbHandle, "COMMIT;", nullptr, nullptr, nullptr);
+        //         ; 
+        //        WorkTypes_new
+        if (query_pragma(db, "SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' "
+                "AND name = 'IX_WorkTypes_FinalPay' AND tbl_name = 'WorkTypes';"))
+            exec_sql(db, "DROP INDEX IX_WorkTypes_FinalPay;");
+        exec_sql(db,
+            "CREATE TABLE IF NOT EXISTS WorkTypes_new (" WORKTYPES_COLUMNS ");"
+            //     ,      CREATE INDEX
+            "CREATE INDEX IF NOT EXISTS IX_WorkTypes_FinalPay ON WorkTypes_new (FinalPay, Name);"
+            "INSERT OR IGNORE INTO MigrationState (Version, LastKey) VALUES (2, 0);"
+            "CREATE TRIGGER IF NOT EXISTS TR_WorkTypes_CopyInsert AFTER INSERT ON WorkTypes BEGIN "
+            "INSERT OR REPLACE INTO WorkTypes_new (Id, Name, BasePay, BonusPercent) "
+            "VALUES (NEW.Id, NEW.Name, NEW.BasePay, NEW.BonusPercent); END;"
+            "CREATE TRIGGER IF NOT EXISTS TR_WorkTypes_CopyUpdate AFTER UPDATE ON WorkTypes BEGIN "
+            "DELETE FROM WorkTypes_new WHERE Id = OLD.Id; "
+            "INSERT OR REPLACE INTO WorkTypes_new (Id, Name, BasePay, BonusPercent) "
+            "VALUES (NEW.Id, NEW.Name, NEW.BasePay, NEW.BonusPercent); END;"
+            "CREATE TRIGGER IF NOT EXISTS TR_WorkTypes_CopyDelete AFTER DELETE ON WorkTypes BEGIN "
+            "DELETE FROM WorkTypes_new WHERE Id = OLD.Id; END;"
+            "COMMIT;");
     }
     catch (...) {
-        sqlite3_exec(dbHandle, "ROLLBACK;", nullptr, nullptr, nullptr);
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
         throw;
     }
+
+    std::size_t batchRows = options.batchRows ? options.batchRows : 50000;
+    Statement last(db, "SELECT LastKey FROM MigrationState WHERE Version = 2;");
+    Statement bound(db, "SELECT MAX(Id) FROM (SELECT Id FROM WorkTypes WHERE Id > ?1 ORDER BY Id LIMIT ?2);");
+    // OR IGNORE: ,   ,  
+    Statement copy(db,
+        "INSERT OR IGNORE INTO WorkTypes_new (Id, Name, BasePay, BonusPercent) "
+        "SELECT Id, Name, BasePay, BonusPercent FROM WorkTypes WHERE Id > ?1 AND Id <= ?2;");
+    Statement save(db, "UPDATE MigrationState SET LastKey = ?1 WHERE Version = 2;");
+
+    for (;;) {
+        exec_sql(db, "BEGIN IMMEDIATE;");
+        try {
+            sqlite3_int64 from = 0;
+            if (sqlite3_step(last.stmt) == SQLITE_ROW) from = sqlite3_column_int64(last.stmt, 0);
+            sqlite3_reset(last.stmt);
+
+            sqlite3_bind_int64(bound.stmt, 1, from);
+            sqlite3_bind_int64(bound.stmt, 2, static_cast<sqlite3_int64>(batchRows));
+            bool more = sqlite3_step(bound.stmt) == SQLITE_ROW && sqlite3_column_type(bound.stmt, 0) != SQLITE_NULL;
+            sqlite3_int64 to = more ? sqlite3_column_int64(bound.stmt, 0) : from;
+            sqlite3_reset(bound.stmt);
+            if (!more) {
+                exec_sql(db, "COMMIT;");
+                break;
+            }
+
+            sqlite3_bind_int64(copy.stmt, 1, from);
+            sqlite3_bind_int64(copy.stmt, 2, to);
+            step_done(copy.stmt, "migration copy failed");
+            result.rowsCopied += static_cast<std::size_t>(sqlite3_changes(db));
+            sqlite3_bind_int64(save.stmt, 1, to);
+            step_done(save.stmt, "migration state update failed");
+            exec_sql(db, "COMMIT;");
+            ++result.batches;
+        }
+        catch (...) {
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            throw;
+        }
+    }
 }
 
-void NativeDb::exportToFile(const std::string& filename)
+static void swap_work_types(sqlite3* db)
 {
-    auto rows = getAll();
-    std::ofstream out(filename, std::ios::binary);
-    if (!out) throw std::runtime_error("cannot open file for write");
+    if (has_table(db, "WorkTypes_new")) {
+        // DROP TABLE    sqlite_sequence:   
+        // AUTOINCREMENT    Id   
+        sqlite3_int64 seq = query_pragma(db, "SELECT seq FROM sqlite_sequence WHERE name = 'WorkTypes';");
+        exec_sql(db,
+            "DROP TRIGGER IF EXISTS TR_WorkTypes_CopyInsert;"
+            "DROP TRIGGER IF EXISTS TR_WorkTypes_CopyUpdate;"
+            "DROP TRIGGER IF EXISTS TR_WorkTypes_CopyDelete;"
+            "DROP TABLE WorkTypes;"
+            "ALTER TABLE WorkTypes_new RENAME TO WorkTypes;"
+            "DELETE FROM MigrationState WHERE Version = 2;");
+        Statement keep(db,
+            "INSERT INTO sqlite_sequence (name, seq) SELECT 'WorkTypes', ?1 "
+            "WHERE NOT EXISTS (SELECT 1 FROM sqlite_sequence WHERE name = 'WorkTypes');");
+        sqlite3_bind_int64(keep.stmt, 1, seq);
+        step_done(keep.stmt, "cannot keep AUTOINCREMENT sequence");
+        Statement raise(db, "UPDATE sqlite_sequence SET seq = MAX(seq, ?1) WHERE name = 'WorkTypes';");
+        sqlite3_bind_int64(raise.stmt, 1, seq);
+        step_done(raise.stmt, "cannot keep AUTOINCREMENT sequence");
+    }
+    // ,   FinalPay   user_version,    
+    exec_sql(db, "CREATE INDEX IF NOT EXISTS IX_WorkTypes_FinalPay ON WorkTypes (FinalPay, Name);");
+}
 
-    // UTF-8 BOM  Excel    
-    const unsigned char bom[3] = { 0xEF, 0xBB, 0xBF };
-    out.write(reinterpret_cast<const char*>(bom), 3);
+//    ImportedFiles ,   WorkTypes   
+//  :     (insertOrReplace, upsert, ,
+// applyChangeset)  ,     .
+// ImportedAt    ,   Unix
+static void add_import_invalidation(sqlite3* db)
+{
+    exec_sql(db,
+        "ALTER TABLE ImportedFiles ADD COLUMN ImportedAt INTEGER NOT NULL DEFAULT 0;"
+        "DELETE FROM ImportedFiles;"
+        "CREATE TRIGGER IF NOT EXISTS TR_WorkTypes_ForgetInsert AFTER INSERT ON WorkTypes BEGIN "
+        "DELETE FROM ImportedFiles; END;"
+        "CREATE TRIGGER IF NOT EXISTS TR_WorkTypes_ForgetUpdate AFTER UPDATE ON WorkTypes BEGIN "
+        "DELETE FROM ImportedFiles; END;"
+        "CREATE TRIGGER IF NOT EXISTS TR_WorkTypes_ForgetDelete AFTER DELETE ON WorkTypes BEGIN "
+        "DELETE FROM ImportedFiles; END;");
+}
 
-    for (auto& t : rows) {
-        out << "\"" << std::get<0>(t) << "\","
-            << std::get<1>(t) << ","
-            << std::get<2>(t) << "\n";
-    }
+struct Migration {
+    int version;
+    const char* name;
+    //      ;  
+    void (*backfill)(sqlite3* db, const MigrationOptions& options, MigrationResult& result);
+    //      PRAGMA user_version
+    void (*apply)(sqlite3* db);
+};
+
+//    ;    
+static const Migration Migrations[] = {
+    { 1, "base schema", nullptr, migrate_base_schema },
+    { 2, "stored FinalPay column", copy_work_types, swap_work_types },
+    { 3, "invalidate import signatures", nullptr, add_import_invalidation },
+};
+
+static const int LatestSchemaVersion = Migrations[sizeof(Migrations) / sizeof(Migrations[0]) - 1].version;
+
+int NativeDb::latestSchemaVersion()
+{
+    return LatestSchemaVersion;
 }
 
+int NativeDb::schemaVersion()
+{
+    std::lock_guard<std::recursive_mutex> lock(pool->writer);
+    return static_cast<int>(query_pragma(dbHandle, "PRAGMA user_version;"));
+}
+
+MigrationReport NativeDb::migrate(const MigrationOptions& options)
+{
+    std::lock_guard<std::recursive_mutex> lock(pool->writer);
+    MigrationReport report;
+    report.fromVersion = static_cast<int>(query_pragma(dbHandle, "PRAGMA user_version;"));
+    report.toVersion = report.fromVersion;
+    if (report.fromVersion > LatestSchemaVersion)
+        throw std::runtime_error("database schema version " + std::to_string(report.fromVersion) +
+            " is newer than this program supports (" + std::to_string(LatestSchemaVersion) + ")");
+
+    if (report.fromVersion == LatestSchemaVersion) return report;
+
+    //        
+    exec_sql(dbHandle,
+        "CREATE TABLE IF NOT EXISTS SchemaMigrations ("
+        "Version INTEGER PRIMARY KEY, "
+        "Name TEXT NOT NULL, "
+        "AppliedAt INTEGER NOT NULL, "
+        "Seconds REAL NOT NULL"
+        ");"
+        "CREATE TABLE IF NOT EXISTS MigrationState ("
+        "Version INTEGER PRIMARY KEY, "
+        "LastKey INTEGER NOT NULL"
+        ");");
+
+    for (const Migration& m : Migrations) {
+        if (m.version <= report.toVersion) continue;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        MigrationResult result;
+        result.version = m.version;
+        result.name = m.name;
+
+        if (m.backfill) m.backfill(dbHandle, options, result);
+
+        exec_sql(dbHandle, "BEGIN IMMEDIATE;");
+        try {
+            m.apply(dbHandle);
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            Statement insert(dbHandle,
+                "INSERT OR REPLACE INTO SchemaMigrations (Version, Name, AppliedAt, Seconds) "
+                "VALUES (?, ?, CAST(strftime('%s', 'now') AS INTEGER), ?);");
+            sqlite3_bind_int(insert.stmt, 1, m.version);
+            sqlite3_bind_text(insert.stmt, 2, m.name, -1, SQLITE_STATIC);
+            sqlite3_bind_double(insert.stmt, 3, result.seconds);
+            step_done(insert.stmt, "cannot record migration");
+            // PRAGMA user_version :    
+            exec_sql(dbHandle, ("PRAGMA user_version = " + std::to_string(m.version) + ";").c_str());
+            exec_sql(dbHandle, "COMMIT;");
+        }
+        catch (...) {
+            sqlite3_exec(dbHandle, "ROLLBACK;", nullptr, nullptr, nullptr);
+            throw;
+        }
+        report.toVersion = m.version;
+        report.applied.push_back(result);
+    }
+    return report;
+}
+
+void NativeDb::initialize()
+{
+    migrate(options.migration);
+}
+
+std::vector<std::tuple<std::string, double, double>> NativeDb::getAll()
+{
+    std::vector<std::tuple<std::string, double, double>> out;
+    for (const RowView& r : rows())
+        out.emplace_back(std::string(r.name), r.basePay, r.bonusPercent);
+    return out;
+}
+
+static void read_work_type(sqlite3_stmt* stmt, WorkTypeRow& row)
+{
+    const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    row.name.assign(text ? text : "", static_cast<std::size_t>(sqlite3_column_bytes(stmt, 0)));
+    row.basePay = sqlite3_column_double(stmt, 1);
+    row.bonusPercent = sqlite3_column_double(stmt, 2);
+    row.finalPay = sqlite3_column_double(stmt, 3);
+}
+
+Page NativeDb::getPage(const PageKey& afterKey, std::size_t limit, PageOrder orderBy, bool descending)
+{
+    Page page;
+    if (limit == 0) return page;
+
+    const char* cmp = descending ? "<" : ">";
+    const char* dir = descending ? " DESC" : "";
+    std::string sql = "SELECT Name, BasePay, BonusPercent, FinalPay FROM WorkTypes";
+    if (orderBy == PageOrder::Name) {
+        if (afterKey.valid) sql += std::string(" WHERE Name ") + cmp + " ?2";
+        sql += std::string(" ORDER BY Name") + dir;
+    }
+    else {
+        // (FinalPay, Name) > (?1, ?2)   :    
+        //   ,   
+        if (afterKey.valid)
+            sql += std::string(" WHERE FinalPay ") + cmp + "= ?1 AND (FinalPay " + cmp + " ?1 OR Name " + cmp + " ?2)";
+        sql += std::string(" ORDER BY FinalPay") + dir + ", Name" + dir;
+    }
+    sql += " LIMIT ?3;";
+
+    ReadLease lease(*this);
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(lease.handle(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error("prepare failed");
+    if (afterKey.valid) {
+        if (orderBy == PageOrder::FinalPay) sqlite3_bind_double(stmt, 1, afterKey.finalPay);
+        sqlite3_bind_text(stmt, 2, afterKey.name.data(), static_cast<int>(afterKey.name.size()), SQLITE_STATIC);
+    }
+    //    ,    
+    sqlite3_bind_int64(stmt, 3, static_cast<sqlite3_int64>(limit) + 1);
+
+    page.rows.reserve(limit);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (page.rows.size() == limit) {
+            page.hasMore = true;
+            break;
+        }
+        WorkTypeRow row;
+        read_work_type(stmt, row);
+        page.rows.push_back(std::move(row));
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE) throw std::runtime_error("select failed");
+
+    if (!page.rows.empty()) {
+        page.next.valid = true;
+        page.next.name = page.rows.back().name;
+        page.next.finalPay = page.rows.back().finalPay;
+    }
+    else {
+        page.next = afterKey;
+    }
+    return page;
+}
+
+static std::vector<WorkTypeRow> read_work_types(sqlite3_stmt* stmt)
+{
+    std::vector<WorkTypeRow> out;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        out.emplace_back();
+        read_work_type(stmt, out.back());
+    }
+    if (rc != SQLITE_DONE) throw std::runtime_error("select failed");
+    return out;
+}
+
+std::vector<WorkTypeRow> NativeDb::getByPayRange(double minPay, double maxPay, std::size_t limit)
+{
+    ReadLease lease(*this);
+    Statement q(lease.handle(),
+        "SELECT Name, BasePay, BonusPercent, FinalPay FROM WorkTypes "
+        "WHERE FinalPay BETWEEN ?1 AND ?2 ORDER BY FinalPay, Name LIMIT ?3;");
+    sqlite3_bind_double(q.stmt, 1, minPay);
+    sqlite3_bind_double(q.stmt, 2, maxPay);
+    // LIMIT -1  SQLite   
+    sqlite3_bind_int64(q.stmt, 3, limit ? static_cast<sqlite3_int64>(limit) : -1);
+    return read_work_types(q.stmt);
+}
+
+std::vector<WorkTypeRow> NativeDb::topByPay(std::size_t k)
+{
+    if (k == 0) return std::vector<WorkTypeRow>();
+    ReadLease lease(*this);
+    //   ,   k 
+    Statement q(lease.handle(),
+        "SELECT Name, BasePay, BonusPercent, FinalPay FROM WorkTypes "
+        "ORDER BY FinalPay DESC, Name DESC LIMIT ?1;");
+    sqlite3_bind_int64(q.stmt, 1, static_cast<sqlite3_int64>(k));
+    return read_work_types(q.stmt);
+}
+
+bool NativeDb::find(const std::string& name, WorkTypeRow& row)
+{
+    ReadLease lease(*this);
+    Statement q(lease.handle(),
+        "SELECT Name, BasePay, BonusPercent, FinalPay FROM WorkTypes WHERE Name = ?1;");
+    sqlite3_bind_text(q.stmt, 1, name.data(), static_cast<int>(name.size()), SQLITE_STATIC);
+    int rc = sqlite3_step(q.stmt);
+    if (rc == SQLITE_DONE) return false;
+    if (rc != SQLITE_ROW) throw std::runtime_error("select failed");
+    read_work_type(q.stmt, row);
+    return true;
+}
+
+static PayStats read_pay_stats(sqlite3_stmt* stmt)
+{
+    PayStats stats;
+    if (sqlite3_step(stmt) != SQLITE_ROW) throw std::runtime_error("select failed");
+    stats.count = static_cast<std::size_t>(sqlite3_column_int64(stmt, 0));
+    if (stats.count == 0) return stats;
+    stats.sum = sqlite3_column_double(stmt, 1);
+    stats.average = sqlite3_column_double(stmt, 2);
+    stats.minPay = sqlite3_column_double(stmt, 3);
+    stats.maxPay = sqlite3_column_double(stmt, 4);
+    return stats;
+}
+
+//     IX_WorkTypes_FinalPay (   FinalPay)
+PayStats NativeDb::payStats()
+{
+    ReadLease lease(*this);
+    Statement q(lease.handle(),
+        "SELECT COUNT(FinalPay), TOTAL(FinalPay), AVG(FinalPay), MIN(FinalPay), MAX(FinalPay) "
+        "FROM WorkTypes INDEXED BY IX_WorkTypes_FinalPay;");
+    return read_pay_stats(q.stmt);
+}
+
+PayStats NativeDb::payStats(double minPay, double maxPay)
+{
+    ReadLease lease(*this);
+    Statement q(lease.handle(),
+        "SELECT COUNT(FinalPay), TOTAL(FinalPay), AVG(FinalPay), MIN(FinalPay), MAX(FinalPay) "
+        "FROM WorkTypes WHERE FinalPay BETWEEN ?1 AND ?2;");
+    sqlite3_bind_double(q.stmt, 1, minPay);
+    sqlite3_bind_double(q.stmt, 2, maxPay);
+    return read_pay_stats(q.stmt);
+}
+
+// ===== RowCursor =====
+
+struct RowCursor::Impl {
+    explicit Impl(NativeDb& db) : lease(db), stmt(nullptr) {}
+    ~Impl() { if (stmt) sqlite3_finalize(stmt); }
+
+    NativeDb::ReadLease lease;
+    sqlite3_stmt* stmt;
+};
+
+RowCursor::RowCursor(std::unique_ptr<Impl> impl) : impl(std::move(impl)), started(false) {}
+
+RowCursor::RowCursor(RowCursor&& other) noexcept
+    : impl(std::move(other.impl)), current(other.current), started(other.started) {}
+
+RowCursor& RowCursor::operator=(RowCursor&& other) noexcept
+{
+    impl = std::move(other.impl);
+    current = other.current;
+    started = other.started;
+    return *this;
+}
+
+//      ,     break
+RowCursor::~RowCursor() = default;
+
+bool RowCursor::next()
+{
+    started = true;
+    if (!impl || !impl->stmt) return false;
+    sqlite3_stmt* stmt = impl->stmt;
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_ROW) {
+        //  :   ,   
+        impl.reset();
+        current = RowView();
+        if (rc != SQLITE_DONE) throw std::runtime_error("select failed");
+        return false;
+    }
+    const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    current.name = std::string_view(text ? text : "", static_cast<std::size_t>(sqlite3_column_bytes(stmt, 0)));
+    current.basePay = sqlite3_column_double(stmt, 1);
+    current.bonusPercent = sqlite3_column_double(stmt, 2);
+    return true;
+}
+
+RowCursor::iterator RowCursor::begin()
+{
+    if (started) return impl ? iterator(this) : iterator();
+    return next() ? iterator(this) : iterator();
+}
+
+RowCursor NativeDb::rows(PageOrder orderBy)
+{
+    std::string sql = "SELECT Name, BasePay, BonusPercent FROM WorkTypes ORDER BY ";
+    sql += orderBy == PageOrder::Name ? "Name" : "FinalPay, Name";
+    sql += ";";
+
+    std::unique_ptr<RowCursor::Impl> impl(new RowCursor::Impl(*this));
+    if (sqlite3_prepare_v2(impl->lease.handle(), sql.c_str(), -1, &impl->stmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error("prepare failed");
+    return RowCursor(std::move(impl));
+}
+
+static std::size_t count_rows(sqlite3* db)
+{
+    std::size_t total = 0;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM WorkTypes;", -1, &stmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error("prepare failed");
+    if (sqlite3_step(stmt) == SQLITE_ROW) total = static_cast<std::size_t>(sqlite3_column_int64(stmt, 0));
+    sqlite3_finalize(stmt);
+    return total;
+}
+
+void NativeDb::clearTable()
+{
+    std::lock_guard<std::recursive_mutex> lock(pool->writer);
+    TriggersOff triggers(dbHandle);
+    //        
+    const char* sql = "DELETE FROM WorkTypes; DELETE FROM ImportedFiles;";
+    char* err = nullptr;
+    int rc = sqlite3_exec(dbHandle, sql, nullptr, nullptr, &err);
+    if (rc != SQLITE_OK) {
+        std::string msg = "SQL error: ";
+        if (err) { msg += err; sqlite3_free(err); }
+        throw std::runtime_error(msg);
+    }
+}
+
+//    : WHERE  UPDATE,  SQLite  
+//   ,  .    INSERT OR REPLACE  DELETE,
+//  Id       .
+#define WORKTYPES_UPSERT_TAIL \
+    " ON CONFLICT(Name) DO UPDATE SET BasePay = excluded.BasePay, BonusPercent = excluded.BonusPercent" \
+    " WHERE BasePay IS NOT excluded.BasePay OR BonusPercent IS NOT excluded.BonusPercent"
+
+static const char* const UpsertSql =
+    "INSERT INTO WorkTypes (Name, BasePay, BonusPercent) VALUES (?, ?, ?)" WORKTYPES_UPSERT_TAIL ";";
+
+// changes() == 0     ;   last_insert_rowid,
+//  .   :      
+// rowid     Id
+static UpsertResult step_upsert(sqlite3* db, sqlite3_stmt* stmt)
+{
+    sqlite3_set_last_insert_rowid(db, 0);
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (rc != SQLITE_DONE) throw std::runtime_error("insert failed");
+    if (sqlite3_changes(db) == 0) return UpsertResult::Unchanged;
+    return sqlite3_last_insert_rowid(db) != 0 ? UpsertResult::Inserted : UpsertResult::Updated;
+}
+
+static void bind_work_type(sqlite3_stmt* stmt, std::string_view name, double basePay, double bonusPercent)
+{
+    sqlite3_bind_text(stmt, 1, name.data(), static_cast<int>(name.size()), SQLITE_STATIC);
+    sqlite3_bind_double(stmt, 2, basePay);
+    sqlite3_bind_double(stmt, 3, bonusPercent);
+}
+
+UpsertResult NativeDb::upsert(const std::string& name, double basePay, double bonusPercent)
+{
+    std::lock_guard<std::recursive_mutex> lock(pool->writer);
+    Statement q(dbHandle, UpsertSql);
+    bind_work_type(q.stmt, name, basePay, bonusPercent);
+    return step_upsert(dbHandle, q.stmt);
+}
+
+void NativeDb::insertOrReplace(const std::string& name, double basePay, double bonusPercent)
+{
+    upsert(name, basePay, bonusPercent);
+}
+
+//  : ,  , ; false    
+static bool read_row(const CsvParser& csv, std::string& name, double& base, double& bonus)
+{
+    if (csv.size() < 3) return false;
+    if (!csvToDouble(csv[1], base) || !csvToDouble(csv[2], bonus))
+        throw std::runtime_error("invalid number at line " + std::to_string(csv.line()));
+    name.assign(csv[0].data(), csv[0].size());
+    return true;
+}
+
+// FNV-1a 64     
+static std::int64_t line_fingerprint(std::string_view s)
+{
+    std::uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return static_cast<std::int64_t>(h);
+}
+
+//   rows : INSERT ... VALUES (?, ?, ?), (?, ?, ?), ... ON CONFLICT ...
+// RETURNING  Id     
+static sqlite3_stmt* prepare_multi_insert(sqlite3* db, std::size_t rows)
+{
+    std::string sql = "INSERT INTO WorkTypes (Name, BasePay, BonusPercent) VALUES ";
+    for (std::size_t i = 0; i < rows; ++i) sql += i ? ", (?, ?, ?)" : "(?, ?, ?)";
+    sql += WORKTYPES_UPSERT_TAIL " RETURNING Id;";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error("prepare failed");
+    return stmt;
+}
+
+// get(i, name, base, bonus)  i- ;    
+// ,   ,    
+template <class Get>
+static UpsertCounts insert_rows(sqlite3* db, std::size_t count, std::size_t perStatement, Get get)
+{
+    UpsertCounts counts;
+    if (count == 0) return counts;
+    // SQLite    (32766   3.32)
+    perStatement = std::max<std::size_t>(1, std::min<std::size_t>(perStatement, 10000));
+    perStatement = std::min(perStatement, count);
+
+    bool ownTransaction = sqlite3_get_autocommit(db) != 0;
+    TriggersOff triggers(db);
+    if (ownTransaction) exec_sql(db, "BEGIN TRANSACTION;");
+
+    sqlite3_stmt* full = nullptr;
+    sqlite3_stmt* tail = nullptr;
+    try {
+        exec_sql(db, "DELETE FROM ImportedFiles;");
+        // AUTOINCREMENT  Id   : ,   
+        // ,  ,   RETURNING  
+        sqlite3_int64 watermark = query_pragma(db, "SELECT MAX(Id) FROM WorkTypes;");
+        std::vector<sqlite3_int64> ids;
+        ids.reserve(perStatement);
+
+        full = prepare_multi_insert(db, perStatement);
+        std::string_view name;
+        double base, bonus;
+        for (std::size_t done = 0; done < count;) {
+            std::size_t rows = std::min(perStatement, count - done);
+            sqlite3_stmt* stmt = full;
+            if (rows < perStatement) {
+                tail = prepare_multi_insert(db, rows);
+                stmt = tail;
+            }
+            for (std::size_t j = 0; j < rows; ++j) {
+                get(done + j, name, base, bonus);
+                int p = static_cast<int>(j * 3);
+                sqlite3_bind_text(stmt, p + 1, name.data(), static_cast<int>(name.size()), SQLITE_STATIC);
+                sqlite3_bind_double(stmt, p + 2, base);
+                sqlite3_bind_double(stmt, p + 3, bonus);
+            }
+            ids.clear();
+            int rc;
+            while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) ids.push_back(sqlite3_column_int64(stmt, 0));
+            sqlite3_reset(stmt);
+            if (rc != SQLITE_DONE) throw std::runtime_error("insert failed");
+
+            //  RETURNING  ;    
+            //    Id       
+            std::sort(ids.begin(), ids.end());
+            for (std::size_t k = 0; k < ids.size(); ++k) {
+                if (ids[k] > watermark && (k == 0 || ids[k] != ids[k - 1])) ++counts.inserted;
+                else ++counts.updated;
+            }
+            if (!ids.empty()) watermark = std::max(watermark, ids.back());
+            counts.unchanged += rows - ids.size();
+            done += rows;
+        }
+        sqlite3_finalize(full);
+        sqlite3_finalize(tail);
+        if (ownTransaction) exec_sql(db, "COMMIT;");
+    }
+    catch (...) {
+        sqlite3_finalize(full);
+        sqlite3_finalize(tail);
+        if (ownTransaction) sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        throw;
+    }
+    return counts;
+}
+
+UpsertCounts NativeDb::insertMany(const std::vector<std::tuple<std::string, double, double>>& rows,
+    const InsertOptions& options)
+{
+    std::lock_guard<std::recursive_mutex> lock(pool->writer);
+    return insert_rows(dbHandle, rows.size(), options.rowsPerStatement,
+        [&](std::size_t i, std::string_view& name, double& base, double& bonus) {
+            name = std::get<0>(rows[i]);
+            base = std::get<1>(rows[i]);
+            bonus = std::get<2>(rows[i]);
+        });
+}
+
+UpsertCounts NativeDb::insertMany(const std::string* names, const double* basePay, const double* bonusPercent,
+    std::size_t count, const InsertOptions& options)
+{
+    std::lock_guard<std::recursive_mutex> lock(pool->writer);
+    return insert_rows(dbHandle, count, options.rowsPerStatement,
+        [&](std::size_t i, std::string_view& name, double& base, double& bonus) {
+            name = names[i];
+            base = basePay[i];
+            bonus = bonusPercent[i];
+        });
+}
+
+UpsertCounts NativeDb::replaceAll(const std::vector<std::tuple<std::string, double, double>>& rows,
+    const InsertOptions& options)
+{
+    std::lock_guard<std::recursive_mutex> lock(pool->writer);
+    TriggersOff triggers(dbHandle);
+    bool ownTransaction = sqlite3_get_autocommit(dbHandle) != 0;
+    if (ownTransaction) exec_sql(dbHandle, "BEGIN TRANSACTION;");
+    try {
+        exec_sql(dbHandle, "DELETE FROM WorkTypes; DELETE FROM ImportedFiles;");
+        UpsertCounts counts = insert_rows(dbHandle, rows.size(), options.rowsPerStatement,
+            [&](std::size_t i, std::string_view& name, double& base, double& bonus) {
+                name = std::get<0>(rows[i]);
+                base = std::get<1>(rows[i]);
+                bonus = std::get<2>(rows[i]);
+            });
+        if (ownTransaction) exec_sql(dbHandle, "COMMIT;");
+        return counts;
+    }
+    catch (...) {
+        if (ownTransaction) sqlite3_exec(dbHandle, "ROLLBACK;", nullptr, nullptr, nullptr);
+        throw;
+    }
+}
+
+static bool write_item(sqlite3_stmt* stmt, const QueuedWrite& item)
+{
+    bind_work_type(stmt, item.name, item.basePay, item.bonusPercent);
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    return rc == SQLITE_DONE;
+}
+
+//    ;    ,    ,
+//     
+static void commit_group(sqlite3* db, std::vector<QueuedWrite>& items)
+{
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, UpsertSql, -1, &stmt, nullptr) != SQLITE_OK) {
+        for (auto& item : items) item.ticket->complete("prepare failed");
+        return;
+    }
+
+    //  WAL  synchronous = NORMAL COMMIT     , 
+    //        :    FULL
+    int sync = -1;
+    try { sync = static_cast<int>(query_pragma(db, "PRAGMA synchronous;")); }
+    catch (...) {}
+    if (sync == 1) sqlite3_exec(db, "PRAGMA synchronous = FULL;", nullptr, nullptr, nullptr);
+
+    bool ok = sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr) == SQLITE_OK;
+    for (std::size_t i = 0; ok && i < items.size(); ++i) ok = write_item(stmt, items[i]);
+    if (ok) ok = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) == SQLITE_OK;
+
+    if (ok) {
+        for (auto& item : items) item.ticket->complete(std::string());
+    }
+    else {
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        for (auto& item : items) {
+            bool written = write_item(stmt, item);
+            item.ticket->complete(written ? std::string() : std::string("insert failed: ") + sqlite3_errmsg(db));
+        }
+    }
+    sqlite3_finalize(stmt);
+    if (sync == 1) sqlite3_exec(db, "PRAGMA synchronous = NORMAL;", nullptr, nullptr, nullptr);
+}
+
+WriteTicket NativeDb::insertOrReplaceAsync(const std::string& name, double basePay, double bonusPercent)
+{
+    WriteTicket ticket;
+    ticket.state = std::make_shared<WriteTicket::State>();
+    QueuedWrite item;
+    item.name = name;
+    item.basePay = basePay;
+    item.bonusPercent = bonusPercent;
+    item.ticket = ticket.state;
+    {
+        std::lock_guard<std::mutex> guard(writeQueue->lock);
+        if (writeQueue->stop) throw std::runtime_error("database is closing");
+        if (!writeQueue->worker.joinable()) writeQueue->worker = std::thread(&NativeDb::runWriteQueue, this);
+        if (writeQueue->pending.empty()) writeQueue->firstQueued = std::chrono::steady_clock::now();
+        writeQueue->pending.push_back(std::move(item));
+    }
+    writeQueue->wake.notify_one();
+    return ticket;
+}
+
+void NativeDb::flushWrites()
+{
+    std::unique_lock<std::mutex> guard(writeQueue->lock);
+    writeQueue->drained.wait(guard, [&] { return writeQueue->pending.empty() && !writeQueue->busy; });
+}
+
+//  :    ,   
+//          
+void NativeDb::runWriteQueue()
+{
+    WriteQueue& q = *writeQueue;
+    const std::chrono::milliseconds window(options.groupCommitWindowMs);
+    const std::size_t threshold = options.groupCommitRows ? options.groupCommitRows : 1;
+
+    std::unique_lock<std::mutex> guard(q.lock);
+    for (;;) {
+        q.wake.wait(guard, [&] { return q.stop || !q.pending.empty(); });
+        if (q.pending.empty()) break;
+        q.wake.wait_until(guard, q.firstQueued + window,
+            [&] { return q.stop || q.pending.size() >= threshold; });
+
+        std::vector<QueuedWrite> items;
+        items.swap(q.pending);
+        q.busy = true;
+        guard.unlock();
+        {
+            std::lock_guard<std::recursive_mutex> writer(pool->writer);
+            commit_group(dbHandle, items);
+        }
+        guard.lock();
+        q.busy = false;
+        q.drained.notify_all();
+    }
+}
+
+void NativeDb::stopWriteQueue()
+{
+    {
+        std::lock_guard<std::mutex> guard(writeQueue->lock);
+        writeQueue->stop = true;
+    }
+    writeQueue->wake.notify_all();
+    if (writeQueue->worker.joinable()) writeQueue->worker.join();
+}
+
+//     ; false     
+static bool load_signature(sqlite3* db, const std::string& source, FileSignature& sig, std::int64_t& importedAt)
+{
+    const char* sql = "SELECT FileSize, ModifiedTime, ContentHash, ImportedAt FROM ImportedFiles WHERE Source = ?;";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error("prepare failed");
+    sqlite3_bind_text(stmt, 1, source.c_str(), -1, SQLITE_TRANSIENT);
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found) {
+        sig.size = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 0));
+        sig.modifiedTime = sqlite3_column_int64(stmt, 1);
+        sig.contentHash = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 2));
+        importedAt = sqlite3_column_int64(stmt, 3);
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+static void store_signature(sqlite3* db, const std::string& source, const FileSignature& sig)
+{
+    const char* sql = "INSERT OR REPLACE INTO ImportedFiles (Source, FileSize, ModifiedTime, ContentHash, ImportedAt) "
+        "VALUES (?, ?, ?, ?, ?);";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error("prepare failed");
+    sqlite3_bind_text(stmt, 1, source.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(sig.size));
+    sqlite3_bind_int64(stmt, 3, sig.modifiedTime);
+    sqlite3_bind_int64(stmt, 4, static_cast<sqlite3_int64>(sig.contentHash));
+    sqlite3_bind_int64(stmt, 5, std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) throw std::runtime_error("insert failed");
+}
+
+// ,    ,  :    
+//   (FAT  2 )        mtime
+static const std::int64_t MtimeSlackNs = 3000000000LL;
+
+//   mtime    ;     mtime 
+//      .
+// current  ,     .
+static bool file_unchanged(sqlite3* db, const std::string& filename, FileSignature& current)
+{
+    current = statFile(filename);
+    FileSignature stored;
+    std::int64_t importedAt = 0;
+    bool known = load_signature(db, filename, stored, importedAt);
+    if (known && stored.size == current.size && stored.modifiedTime == current.modifiedTime &&
+        importedAt - current.modifiedTime > MtimeSlackNs)
+        return true;
+    current.contentHash = hashFile(filename);
+    if (known && stored.size == current.size && stored.contentHash == current.contentHash) {
+        store_signature(db, filename, current);
+        return true;
+    }
+    return false;
+}
+
+//       :  
+//  ,    ,   
+static void record_import(sqlite3* db, const std::string& filename, bool keepSignature,
+    const FileSignature& current)
+{
+    const char* sql = "DELETE FROM ImportedFiles WHERE Source <> ?;";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error("prepare failed");
+    sqlite3_bind_text(stmt, 1, filename.c_str(), -1, SQLITE_TRANSIENT);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) throw std::runtime_error("delete failed");
+    if (keepSignature) store_signature(db, filename, current);
+    else exec_sql(db, "DELETE FROM ImportedFiles;");
+}
+
+ImportStats NativeDb::importFromFile(const std::string& filename, const ImportOptions& options)
+{
+    std::lock_guard<std::recursive_mutex> lock(pool->writer);
+    ImportStats stats;
+    FileSignature current;
+    if (options.skipUnchanged && file_unchanged(dbHandle, filename, current)) {
+        stats.fileUnchanged = true;
+        return stats;
+    }
+    BulkLoadGuard bulk(*this, options.bulkLoad);
+    TriggersOff triggers(dbHandle);
+
+    Statement upsert(dbHandle, UpsertSql);
+    UpsertCounts counts;
+    std::size_t inTransaction = 0;
+    exec_sql(dbHandle, "BEGIN TRANSACTION;");
+    try {
+        //   COMMIT      
+        exec_sql(dbHandle, "DELETE FROM ImportedFiles;");
+        //  :    ,     
+        runImportPipeline(filename, options, [&](const RowBatch& batch) {
+            for (const ImportIssue& issue : batch.issues) {
+                if (issue.kind == ImportIssueKind::InvalidNumber)
+                    throw std::runtime_error("invalid number at line " + std::to_string(issue.line));
+            }
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                bind_work_type(upsert.stmt, batch.name(i), batch.basePay[i], batch.bonusPercent[i]);
+                UpsertResult r = step_upsert(dbHandle, upsert.stmt);
+                counts.add(r);
+                //           
+                if (r == UpsertResult::Unchanged) continue;
+
+                if (options.batchSize && ++inTransaction >= options.batchSize) {
+                    exec_sql(dbHandle, "COMMIT;");
+                    exec_sql(dbHandle, "BEGIN TRANSACTION;");
+                    inTransaction = 0;
+                }
+            }
+        }, stats);
+        record_import(dbHandle, filename, options.skipUnchanged, current);
+        exec_sql(dbHandle, "COMMIT;");
+    }
+    catch (...) {
+        sqlite3_exec(dbHandle, "ROLLBACK;", nullptr, nullptr, nullptr);
+        throw;
+    }
+    stats.rowsInserted = counts.inserted;
+    stats.rowsUpdated = counts.updated;
+    stats.rowsUnchanged = counts.unchanged;
+    stats.rowsWritten = counts.inserted + counts.updated;
+    return stats;
+}
+
+ImportStats NativeDb::syncFromFile(const std::string& filename, const ImportOptions& options)
+{
+    std::lock_guard<std::recursive_mutex> lock(pool->writer);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ImportStats stats;
+    FileSignature current;
+    if (options.skipUnchanged && file_unchanged(dbHandle, filename, current)) {
+        stats.fileUnchanged = true;
+        return stats;
+    }
+    BulkLoadGuard bulk(*this, options.bulkLoad);
+    TriggersOff triggers(dbHandle);
+
+    // 1.       ,     
+    ExternalSorter sorter(options.sortTempDir, options.sortMemoryBytes);
+    runImportPipeline(filename, options, [&](const RowBatch& batch) {
+        for (const ImportIssue& issue : batch.issues) {
+            if (issue.kind == ImportIssueKind::InvalidNumber)
+                throw std::runtime_error("invalid number at line " + std::to_string(issue.line));
+        }
+        for (std::size_t i = 0; i < batch.size(); ++i)
+            sorter.add(batch.name(i), batch.basePay[i], batch.bonusPercent[i]);
+    }, stats);
+    sorter.finish();
+
+    // 2.      :    
+    //    ,  - ,        
+    const int ChunkRows = 8192;
+    Statement firstChunk(dbHandle,
+        "SELECT Name, BasePay, BonusPercent FROM WorkTypes ORDER BY Name LIMIT ?;");
+    Statement nextChunk(dbHandle,
+        "SELECT Name, BasePay, BonusPercent FROM WorkTypes WHERE Name > ? ORDER BY Name LIMIT ?;");
+    Statement insert(dbHandle, "INSERT INTO WorkTypes (Name, BasePay, BonusPercent) VALUES (?, ?, ?);");
+    Statement update(dbHandle, "UPDATE WorkTypes SET BasePay = ?, BonusPercent = ? WHERE Name = ?;");
+    Statement remove(dbHandle, "DELETE FROM WorkTypes WHERE Name = ?;");
+
+    auto doInsert = [&](const SortedRow& r) {
+        sqlite3_bind_text(insert.stmt, 1, r.name.data(), static_cast<int>(r.name.size()), SQLITE_STATIC);
+        sqlite3_bind_double(insert.stmt, 2, r.basePay);
+        sqlite3_bind_double(insert.stmt, 3, r.bonusPercent);
+        step_done(insert.stmt, "insert failed");
+        ++stats.rowsInserted;
+    };
+
+    std::vector<SortedRow> chunk;
+    std::string lastKey;
+    SortedRow fileRow;
+    bool haveFile = sorter.next(fileRow);
+    bool first = true;
+    std::size_t committedAt = 0;
+
+    exec_sql(dbHandle, "BEGIN TRANSACTION;");
+    try {
+        exec_sql(dbHandle, "DELETE FROM ImportedFiles;");
+        for (;;) {
+            sqlite3_stmt* sel = first ? firstChunk.stmt : nextChunk.stmt;
+            int limitIndex = first ? 1 : 2;
+            if (!first) sqlite3_bind_text(sel, 1, lastKey.data(), static_cast<int>(lastKey.size()), SQLITE_STATIC);
+            sqlite3_bind_int(sel, limitIndex, ChunkRows);
+            chunk.clear();
+            int rc;
+            while ((rc = sqlite3_step(sel)) == SQLITE_ROW) {
+                SortedRow r;
+                const char* text = reinterpret_cast<const char*>(sqlite3_column_text(sel, 0));
+                r.name.assign(text ? text : "", static_cast<std::size_t>(sqlite3_column_bytes(sel, 0)));
+                r.basePay = sqlite3_column_double(sel, 1);
+                r.bonusPercent = sqlite3_column_double(sel, 2);
+                chunk.push_back(std::move(r));
+            }
+            sqlite3_reset(sel);
+            if (rc != SQLITE_DONE) throw std::runtime_error("select failed");
+            first = false;
+
+            for (const SortedRow& db : chunk) {
+                while (haveFile && fileRow.name < db.name) {
+                    doInsert(fileRow);
+                    haveFile = sorter.next(fileRow);
+                }
+                if (haveFile && fileRow.name == db.name) {
+                    if (fileRow.basePay != db.basePay || fileRow.bonusPercent != db.bonusPercent) {
+                        sqlite3_bind_double(update.stmt, 1, fileRow.basePay);
+                        sqlite3_bind_double(update.stmt, 2, fileRow.bonusPercent);
+                        sqlite3_bind_text(update.stmt, 3, db.name.data(), static_cast<int>(db.name.size()), SQLITE_STATIC);
+                        step_done(update.stmt, "update failed");
+                        ++stats.rowsUpdated;
+                    }
+                    else {
+                        ++stats.rowsUnchanged;
+                    }
+                    haveFile = sorter.next(fileRow);
+                }
+                else {
+                    sqlite3_bind_text(remove.stmt, 1, db.name.data(), static_cast<int>(db.name.size()), SQLITE_STATIC);
+                    step_done(remove.stmt, "delete failed");
+                    ++stats.rowsDeleted;
+                }
+            }
+
+            if (chunk.size() < static_cast<std::size_t>(ChunkRows)) {
+                //       
+                while (haveFile) {
+                    doInsert(fileRow);
+                    haveFile = sorter.next(fileRow);
+                }
+                break;
+            }
+            lastKey = chunk.back().name;
+
+            if (options.cancel) options.cancel->check();
+            std::size_t written = stats.rowsInserted + stats.rowsUpdated + stats.rowsDeleted;
+            if (options.batchSize && written - committedAt >= options.batchSize) {
+                exec_sql(dbHandle, "COMMIT;");
+                exec_sql(dbHandle, "BEGIN TRANSACTION;");
+                committedAt = written;
+            }
+        }
+        record_import(dbHandle, filename, options.skipUnchanged, current);
+        exec_sql(dbHandle, "COMMIT;");
+    }
+    catch (...) {
+        sqlite3_exec(dbHandle, "ROLLBACK;", nullptr, nullptr, nullptr);
+        throw;
+    }
+    stats.rowsWritten = stats.rowsInserted + stats.rowsUpdated + stats.rowsDeleted;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+ValidationReport NativeDb::validateFile(const std::string& filename, const ImportOptions& options,
+    std::size_t maxIssues)
+{
+    ValidationReport report;
+    std::unordered_map<std::string, std::size_t> seen;
+
+    auto note = [&](const ImportIssue& issue) {
+        if (report.issues.size() < maxIssues) report.issues.push_back(issue);
+        else report.truncated = true;
+    };
+
+    ImportStats stats;
+    runImportPipeline(filename, options, [&](const RowBatch& batch) {
+        //     :     
+        std::size_t next = 0;
+        std::size_t invalid = 0;
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            std::size_t line = batch.lines[i];
+            for (; next < batch.issues.size() && batch.issues[next].line < line; ++next)
+                note(batch.issues[next]);
+
+            //   ,    WorkTypeBase
+            ImportIssue value;
+            value.line = line;
+            if (batch.name(i).empty()) {
+                value.column = 1;
+                value.kind = ImportIssueKind::EmptyName;
+            }
+            else if (batch.basePay[i] <= 0) {
+                value.column = 2;
+                value.kind = ImportIssueKind::InvalidBasePay;
+            }
+            else if (batch.bonusPercent[i] < 0) {
+                value.column = 3;
+                value.kind = ImportIssueKind::NegativeBonus;
+            }
+            if (value.column) {
+                ++invalid;
+                note(value);
+            }
+
+            auto res = seen.emplace(std::string(batch.name(i)), line);
+            if (!res.second) {
+                ImportIssue issue;
+                issue.line = line;
+                issue.column = 1;
+                issue.kind = ImportIssueKind::DuplicateName;
+                issue.firstLine = res.first->second;
+                ++report.duplicateCount;
+                note(issue);
+            }
+        }
+        for (; next < batch.issues.size(); ++next) note(batch.issues[next]);
+
+        report.rowsValid += batch.size() - invalid;
+        report.errorCount += batch.issues.size() + invalid;
+    }, stats);
+
+    report.rowsChecked = report.rowsValid + report.errorCount;
+    report.seconds = stats.seconds;
+    return report;
+}
+
+std::string ValidationReport::text() const
+{
+    std::string out = "rows: " + std::to_string(rowsChecked)
+        + ", valid: " + std::to_string(rowsValid)
+        + ", errors: " + std::to_string(errorCount)
+        + ", duplicates: " + std::to_string(duplicateCount) + "\n";
+    for (const ImportIssue& issue : issues) {
+        out += "line " + std::to_string(issue.line);
+        if (issue.column) out += ", column " + std::to_string(issue.column);
+        switch (issue.kind) {
+        case ImportIssueKind::TooFewFields: out += ": too few fields"; break;
+        case ImportIssueKind::InvalidNumber: out += ": invalid number"; break;
+        case ImportIssueKind::DuplicateName:
+            out += ": duplicate name, first at line " + std::to_string(issue.firstLine);
+            break;
+        case ImportIssueKind::EmptyName: out += ": empty name"; break;
+        case ImportIssueKind::InvalidBasePay: out += ": base pay must be > 0"; break;
+        case ImportIssueKind::NegativeBonus: out += ": bonus must be >= 0"; break;
+        }
+        out += "\n";
+    }
+    if (truncated) out += "...\n";
+    return out;
+}
+
+std::size_t NativeDb::importIncremental(const std::string& filename)
+{
+    std::lock_guard<std::recursive_mutex> lock(pool->writer);
+    //          
+    if (compressionForFile(filename) != Compression::None) {
+        importFromFile(filename);
+        return 0;
+    }
+
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) throw std::runtime_error("cannot open file");
+    in.seekg(0, std::ios::end);
+    std::int64_t size = static_cast<std::int64_t>(in.tellg());
+
+    std::int64_t offset = 0, lastLength = 0, fingerprint = 0;
+    bool known = false;
+    {
+        const char* sql = "SELECT ByteOffset, LastLineLength, Fingerprint FROM ImportState WHERE Source = ?;";
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(dbHandle, sql, -1, &stmt, nullptr) != SQLITE_OK)
+            throw std::runtime_error("prepare failed");
+        sqlite3_bind_text(stmt, 1, filename.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            offset = sqlite3_column_int64(stmt, 0);
+            lastLength = sqlite3_column_int64(stmt, 1);
+            fingerprint = sqlite3_column_int64(stmt, 2);
+            known = true;
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    //    ,      
+    //      ;    
+    //  ()    .
+    std::int64_t start = 0;
+    if (known && offset <= size && lastLength <= offset) {
+        std::string last(static_cast<std::size_t>(lastLength), '\0');
+        in.seekg(offset - lastLength);
+        if (lastLength == 0 || in.read(&last[0], lastLength)) {
+            if (line_fingerprint(last) == fingerprint) start = offset;
+        }
+    }
+    in.close();
+
+    InputFile file(filename, static_cast<std::uint64_t>(start));
+    std::size_t applied = 0;
+    Statement upsert(dbHandle, UpsertSql);
+    sqlite3_exec(dbHandle, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
+    try {
+        CsvParser csv(file.stream());
+        std::int64_t pos = start;
+        std::string name, last;
+        double base, bonus;
+        bool consumed = false;
+        while (csv.next()) {
+            //            
+            if (!csv.terminated()) break;
+            pos = start + static_cast<std::int64_t>(csv.offset());
+            last.assign(csv.raw().data(), csv.raw().size());
+            consumed = true;
+            if (read_row(csv, name, base, bonus)) {
+                bind_work_type(upsert.stmt, name, base, bonus);
+                step_upsert(dbHandle, upsert.stmt);
+                ++applied;
+            }
+        }
+
+        if (consumed || !known || start != offset) {
+            const char* sql =
+                "INSERT OR REPLACE INTO ImportState (Source, ByteOffset, LastLineLength, Fingerprint) "
+                "VALUES (?, ?, ?, ?);";
+            sqlite3_stmt* stmt = nullptr;
+            if (sqlite3_prepare_v2(dbHandle, sql, -1, &stmt, nullptr) != SQLITE_OK)
+                throw std::runtime_error("prepare failed");
+            sqlite3_bind_text(stmt, 1, filename.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(stmt, 2, pos);
+            sqlite3_bind_int64(stmt, 3, static_cast<std::int64_t>(last.size()));
+            sqlite3_bind_int64(stmt, 4, line_fingerprint(last));
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                sqlite3_finalize(stmt);
+                throw std::runtime_error("insert failed");
+            }
+            sqlite3_finalize(stmt);
+        }
+        sqlite3_exec(dbHandle, "COMMIT;", nullptr, nullptr, nullptr);
+    }
+    catch (...) {
+        sqlite3_exec(dbHandle, "ROLLBACK;", nullptr, nullptr, nullptr);
+        throw;
+    }
+    return applied;
+}
+
+// =====  CSV =====
+
+struct CsvExportWriter::Impl {
+    std::string filename;
+    ExportOptions options;
+    OutputFile file;
+    ProgressMeter meter;
+    ExportStats stats;
+    bool finished = false;
+
+    Impl(const std::string& filename, std::size_t totalRows, const ExportOptions& options)
+        : filename(filename), options(options), file(filename),
+        meter(options.progress, options.progressInterval, 0, totalRows) {}
+};
+
+CsvExportWriter::CsvExportWriter(const std::string& filename, std::size_t totalRows, const ExportOptions& options)
+    : impl(new Impl(filename, totalRows, options))
+{
+    // UTF-8 BOM  Excel    
+    const unsigned char bom[3] = { 0xEF, 0xBB, 0xBF };
+    impl->file.stream().write(reinterpret_cast<const char*>(bom), 3);
+}
+
+CsvExportWriter::~CsvExportWriter()
+{
+    if (impl->finished) return;
+    try { impl->file.close(); }
+    catch (...) {}
+    std::remove(impl->filename.c_str());
+}
+
+void CsvExportWriter::append(std::string_view name, double basePay, double bonusPercent)
+{
+    std::ostream& out = impl->file.stream();
+    out << '"';
+    for (char c : name) {
+        if (c == '"') out << '"';  //    
+        out << c;
+    }
+    out << "\","
+        << basePay << ","
+        << bonusPercent << "\n";
+
+    //        
+    if ((++impl->stats.rowsExported & 4095) == 0) {
+        if (impl->options.cancel) impl->options.cancel->check();
+        impl->meter.update(impl->file.bytesWritten(), impl->stats.rowsExported, 0);
+    }
+}
+
+ExportStats CsvExportWriter::finish()
+{
+    if (impl->options.cancel) impl->options.cancel->check();
+    ExportStats& stats = impl->stats;
+    stats.bytesWritten = impl->file.bytesWritten();
+    impl->file.close();
+    impl->finished = true;
+    impl->meter.update(stats.bytesWritten, stats.rowsExported, 0);
+    ProgressInfo info = impl->meter.finish();
+    stats.seconds = info.elapsedSeconds;
+    stats.rowsPerSecond = info.rowsPerSecond;
+    stats.bytesPerSecond = info.bytesPerSecond;
+    return stats;
+}
+
+ExportStats NativeDb::exportToFile(const std::string& filename, const ExportOptions& options)
+{
+    if (ArrowWriter::isArrowFile(filename)) return exportToArrow(filename, options);
+
+    //       ,   
+    RowCursor cursor = rows();
+    CsvExportWriter writer(filename, count_rows(cursor.impl->lease.handle()), options);
+    for (const RowView& r : cursor) writer.append(r.name, r.basePay, r.bonusPercent);
+    return writer.finish();
+}
+
+ExportStats NativeDb::exportToArrow(const std::string& filename, const ExportOptions& options)
+{
+    //       ,      
+    ReadLease lease(*this);
+    std::size_t total = count_rows(lease.handle());
+
+    const char* sql = "SELECT Name, BasePay, BonusPercent FROM WorkTypes ORDER BY Name;";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(lease.handle(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error("prepare failed");
+
+    ExportStats stats;
+    ProgressMeter meter(options.progress, options.progressInterval, 0, total);
+    try {
+        ArrowWriter writer(filename, ArrowWriter::formatForFile(filename), options.arrowBatchRows);
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            std::size_t len = static_cast<std::size_t>(sqlite3_column_bytes(stmt, 0));
+            writer.append(std::string_view(text ? text : "", len),
+                sqlite3_column_double(stmt, 1), sqlite3_column_double(stmt, 2));
+
+            if ((++stats.rowsExported & 4095) == 0) {
+                if (options.cancel) options.cancel->check();
+                meter.update(writer.bytesWritten(), stats.rowsExported, 0);
+            }
+        }
+        if (rc != SQLITE_DONE) throw std::runtime_error("select failed");
+        if (options.cancel) options.cancel->check();
+        writer.close();
+        stats.bytesWritten = writer.bytesWritten();
+    }
+    catch (...) {
+        sqlite3_finalize(stmt);
+        std::remove(filename.c_str());
+        throw;
+    }
+    sqlite3_finalize(stmt);
+
+    meter.update(stats.bytesWritten, stats.rowsExported, 0);
+    ProgressInfo info = meter.finish();
+    stats.seconds = info.elapsedSeconds;
+    stats.rowsPerSecond = info.rowsPerSecond;
+    stats.bytesPerSecond = info.bytesPerSecond;
+    return stats;
+}
+
+// ===== Changeset =====
+
+#ifdef NATIVEDB_SESSIONS
+static std::string changeset_text(sqlite3_value* v)
+{
+    const unsigned char* text = v ? sqlite3_value_text(v) : nullptr;
+    return text ? std::string(reinterpret_cast<const char*>(text), static_cast<std::size_t>(sqlite3_value_bytes(v)))
+        : std::string();
+}
+
+struct ApplyContext {
+    const ConflictHandler* handler;
+    ApplyStats* stats;
+    std::exception_ptr error;
+};
+
+//  : 0  Id, 1  Name (  WorkTypes)
+static ChangeConflict describe_conflict(int kind, sqlite3_changeset_iter* it)
+{
+    ChangeConflict c;
+    switch (kind) {
+    case SQLITE_CHANGESET_DATA: c.kind = ConflictKind::Data; break;
+    case SQLITE_CHANGESET_NOTFOUND: c.kind = ConflictKind::NotFound; break;
+    case SQLITE_CHANGESET_CONFLICT: c.kind = ConflictKind::Conflict; break;
+    case SQLITE_CHANGESET_CONSTRAINT: c.kind = ConflictKind::Constraint; break;
+    default: c.kind = ConflictKind::ForeignKey; return c;   //   
+    }
+    const char* table = nullptr;
+    int columns = 0, op = 0, indirect = 0;
+    sqlite3changeset_op(it, &table, &columns, &op, &indirect);
+    c.op = op == SQLITE_INSERT ? ChangeOp::Insert : op == SQLITE_UPDATE ? ChangeOp::Update : ChangeOp::Delete;
+
+    sqlite3_value* id = nullptr;
+    sqlite3_value* name = nullptr;
+    if (op == SQLITE_INSERT) {
+        sqlite3changeset_new(it, 0, &id);
+        sqlite3changeset_new(it, 1, &name);
+    }
+    else {
+        sqlite3changeset_old(it, 0, &id);
+        if (op == SQLITE_UPDATE) sqlite3changeset_new(it, 1, &name);
+        if (!name) sqlite3changeset_old(it, 1, &name);
+    }
+    //  UPDATE    Name     
+    if (!name && (kind == SQLITE_CHANGESET_DATA || kind == SQLITE_CHANGESET_CONFLICT))
+        sqlite3changeset_conflict(it, 1, &name);
+    if (id) c.id = sqlite3_value_int64(id);
+    c.name = changeset_text(name);
+    return c;
+}
+
+static ConflictAction default_conflict_action(const ChangeConflict& c)
+{
+    switch (c.kind) {
+    case ConflictKind::Data:
+    case ConflictKind::Conflict: return ConflictAction::Replace;
+    case ConflictKind::NotFound: return ConflictAction::Omit;
+    default: return ConflictAction::Abort;
+    }
+}
+
+static int on_conflict(void* context, int kind, sqlite3_changeset_iter* it)
+{
+    ApplyContext& ctx = *static_cast<ApplyContext*>(context);
+    ++ctx.stats->conflicts;
+    ConflictAction action;
+    try {
+        ChangeConflict c = describe_conflict(kind, it);
+        action = *ctx.handler ? (*ctx.handler)(c) : default_conflict_action(c);
+    }
+    catch (...) {
+        //      C- SQLite
+        ctx.error = std::current_exception();
+        return SQLITE_CHANGESET_ABORT;
+    }
+    if (action == ConflictAction::Replace
+        && (kind == SQLITE_CHANGESET_DATA || kind == SQLITE_CHANGESET_CONFLICT)) {
+        ++ctx.stats->replaced;
+        return SQLITE_CHANGESET_REPLACE;
+    }
+    if (action == ConflictAction::Abort) return SQLITE_CHANGESET_ABORT;
+    ++ctx.stats->omitted;
+    return SQLITE_CHANGESET_OMIT;
+}
+
+static int only_work_types(void*, const char* table)
+{
+    return std::strcmp(table, "WorkTypes") == 0;
+}
+#endif
+
+Changeset NativeDb::takeChangeset()
+{
+#ifdef NATIVEDB_SESSIONS
+    std::lock_guard<std::recursive_mutex> lock(pool->writer);
+    if (!changes) throw std::logic_error("takeChangeset: DbOptions::recordChanges is off");
+    //      changeset,    
+    if (!sqlite3_get_autocommit(dbHandle)) throw std::logic_error("takeChangeset inside a transaction");
+
+    int size = 0;
+    void* data = nullptr;
+    int rc = sqlite3session_changeset(changes->session, &size, &data);
+    if (rc != SQLITE_OK) {
+        sqlite3_free(data);
+        //   ,       NativeDb
+        if (rc == SQLITE_SCHEMA) throw std::runtime_error(GeneratedColumnMessage);
+        throw std::runtime_error("cannot build changeset");
+    }
+    Changeset out(static_cast<unsigned char*>(data), static_cast<unsigned char*>(data) + size);
+    sqlite3_free(data);
+
+    //      changeset;  ,   
+    sqlite3_session* fresh = create_session(dbHandle);
+    sqlite3session_delete(changes->session);
+    changes->session = fresh;
+    return out;
+#else
+    throw std::runtime_error(NoSessionsMessage);
+#endif
+}
+
+ApplyStats NativeDb::applyChangeset(const Changeset& changeset, const ConflictHandler& onConflict)
+{
+#ifdef NATIVEDB_SESSIONS
+    std::lock_guard<std::recursive_mutex> lock(pool->writer);
+    ApplyStats stats;
+    if (changeset.empty()) return stats;
+    int size = static_cast<int>(changeset.size());
+    void* data = const_cast<unsigned char*>(changeset.data());
+
+    sqlite3_changeset_iter* it = nullptr;
+    if (sqlite3changeset_start(&it, size, data) != SQLITE_OK) throw std::runtime_error("invalid changeset");
+    while (sqlite3changeset_next(it) == SQLITE_ROW) ++stats.changes;
+    if (sqlite3changeset_finalize(it) != SQLITE_OK) throw std::runtime_error("invalid changeset");
+
+    //     : Abort   
+    ApplyContext ctx = { &onConflict, &stats, nullptr };
+    int rc = sqlite3changeset_apply(dbHandle, size, data, only_work_types, on_conflict, &ctx);
+    if (ctx.error) std::rethrow_exception(ctx.error);
+    if (rc == SQLITE_ABORT) throw std::runtime_error("changeset apply aborted on conflict");
+    if (rc != SQLITE_OK) throw std::runtime_error(std::string("changeset apply failed: ") + sqlite3_errmsg(dbHandle));
+    return stats;
+#else
+    (void)changeset;
+    (void)onConflict;
+    throw std::runtime_error(NoSessionsMessage);
+#endif
+}
+
+Changeset NativeDb::combineChangesets(const std::vector<Changeset>& parts)
+{
+#ifdef NATIVEDB_SESSIONS
+    sqlite3_changegroup* group = nullptr;
+    if (sqlite3changegroup_new(&group) != SQLITE_OK) throw std::runtime_error("cannot create changegroup");
+    for (const Changeset& part : parts) {
+        if (part.empty()) continue;
+        if (sqlite3changegroup_add(group, static_cast<int>(part.size()),
+                const_cast<unsigned char*>(part.data())) != SQLITE_OK) {
+            sqlite3changegroup_delete(group);
+            throw std::runtime_error("invalid changeset");
+        }
+    }
+    int size = 0;
+    void* data = nullptr;
+    int rc = sqlite3changegroup_output(group, &size, &data);
+    sqlite3changegroup_delete(group);
+    if (rc != SQLITE_OK) {
+        sqlite3_free(data);
+        throw std::runtime_error("cannot combine changesets");
+    }
+    Changeset out(static_cast<unsigned char*>(data), static_cast<unsigned char*>(data) + size);
+    sqlite3_free(data);
+    return out;
+#else
+    (void)parts;
+    throw std::runtime_error(NoSessionsMessage);
+#endif
+}
+
+void NativeDb::saveChangeset(const std::string& filename, const Changeset& changeset)
+{
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("cannot create file: " + filename);
+    out.write(reinterpret_cast<const char*>(changeset.data()), static_cast<std::streamsize>(changeset.size()));
+    out.close();
+    if (!out) throw std::runtime_error("write failed: " + filename);
+}
+
+Changeset NativeDb::loadChangeset(const std::string& filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) throw std::runtime_error("cannot open file: " + filename);
+    return Changeset(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// =====   =====
+
+BackupJob NativeDb::backupTo(const std::string& target, const BackupOptions& options)
+{
+    BackupJob job;
+    job.state = std::make_shared<BackupJob::State>();
+    job.state->path = target;
+    job.state->options = options;
+    if (options.cancel) job.state->cancel = *options.cancel;
+
+    std::lock_guard<std::mutex> guard(backups->lock);
+    //     ,     
+    for (std::size_t i = backups->jobs.size(); i-- > 0;) {
+        BackupJob finished;
+        finished.state = backups->jobs[i];
+        if (!finished.ready()) continue;
+        backups->threads[i].join();
+        backups->threads.erase(backups->threads.begin() + i);
+        backups->jobs.erase(backups->jobs.begin() + i);
+    }
+    backups->jobs.push_back(job.state);
+    backups->threads.push_back(std::thread(&NativeDb::runBackup, this, job.state));
+    return job;
+}
+
+void NativeDb::runBackup(std::shared_ptr<BackupJob::State> job)
+{
+    const BackupOptions& o = job->options;
+    const int pagesPerStep = o.pagesPerStep > 0 ? o.pagesPerStep : 100;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    BackupStats stats;
+    std::exception_ptr failure;
+
+    bool existed = false;
+    {
+        std::ifstream probe(job->path, std::ios::binary);
+        existed = static_cast<bool>(probe);
+    }
+    sqlite3* dest = nullptr;
+    sqlite3_backup* backup = nullptr;
+    try {
+        if (sqlite3_open(job->path.c_str(), &dest) != SQLITE_OK)
+            throw std::runtime_error(std::string("cannot open backup file: ") + sqlite3_errmsg(dest));
+        if (o.synchronous != SyncLevel::Default)
+            exec_sql(dest, std::string("PRAGMA synchronous = ") + SyncNames[static_cast<int>(o.synchronous)] + ";");
+        {
+            std::lock_guard<std::recursive_mutex> lock(pool->writer);
+            backup = sqlite3_backup_init(dest, "main", dbHandle, "main");
+        }
+        if (!backup) throw std::runtime_error(std::string("backup init failed: ") + sqlite3_errmsg(dest));
+
+        ProgressMeter meter(o.progress, o.progressInterval, 0);
+        std::uint64_t pageSize = 0;
+        int lastCopied = 0;
+        for (;;) {
+            job->cancel.check();
+            int rc;
+            {
+                //    -   :  
+                // SQLite    ,  
+                std::lock_guard<std::recursive_mutex> lock(pool->writer);
+                rc = sqlite3_backup_step(backup, pagesPerStep);
+                if (!pageSize) pageSize = static_cast<std::uint64_t>(query_pragma(dbHandle, "PRAGMA page_size;"));
+            }
+            ++stats.steps;
+            int remaining = sqlite3_backup_remaining(backup);
+            stats.pagesTotal = sqlite3_backup_pagecount(backup);
+            stats.pagesCopied = stats.pagesTotal - remaining;
+            //        ,   
+            if (stats.pagesCopied < lastCopied) ++stats.restarts;
+            lastCopied = stats.pagesCopied;
+            meter.setBytesTotal(static_cast<std::uint64_t>(stats.pagesTotal) * pageSize);
+            meter.update(static_cast<std::uint64_t>(stats.pagesCopied) * pageSize, 0, 0);
+
+            if (rc == SQLITE_DONE) break;
+            if (rc != SQLITE_OK && rc != SQLITE_BUSY && rc != SQLITE_LOCKED)
+                throw std::runtime_error(std::string("backup step failed: ") + sqlite3_errstr(rc));
+            if (o.pauseMs) std::this_thread::sleep_for(std::chrono::milliseconds(o.pauseMs));
+        }
+        meter.finish();
+    }
+    catch (...) {
+        failure = std::current_exception();
+    }
+    // finish     :    
+    if (backup) {
+        std::lock_guard<std::recursive_mutex> lock(pool->writer);
+        int rc = sqlite3_backup_finish(backup);
+        if (!failure && rc != SQLITE_OK)
+            failure = std::make_exception_ptr(std::runtime_error(std::string("backup failed: ") + sqlite3_errstr(rc)));
+    }
+    sqlite3_close(dest);
+    if (failure && !existed) std::remove(job->path.c_str());
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    job->complete(stats, failure);
+}
+
+//   : -  
+void NativeDb::stopBackups()
+{
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> guard(backups->lock);
+        for (auto& job : backups->jobs) job->cancel.cancel();
+        threads.swap(backups->threads);
+        backups->jobs.clear();
+    }
+    for (std::thread& t : threads) t.join();
+}
+
+// =====    =====
+
+bool NativeDb::checkpoint()
+{
+    if (!options.inMemory) throw std::logic_error("checkpoint: database is not in memory");
+    std::lock_guard<std::mutex> once(checkpointer->running);
+    sqlite3_int64 changes;
+    {
+        std::lock_guard<std::recursive_mutex> lock(pool->writer);
+        changes = sqlite3_total_changes64(dbHandle);
+    }
+    if (changes == checkpointer->saved) return false;
+
+    //   -,   backupTo:      ,
+    //            
+    BackupOptions o;
+    o.pagesPerStep = 1024;
+    o.pauseMs = 1;
+    o.synchronous = options.checkpointSync;
+    backupTo(path, o).wait();
+    checkpointer->saved = changes;
+    return true;
+}
+
+void NativeDb::runCheckpoints()
+{
+    Checkpointer& c = *checkpointer;
+    const std::chrono::milliseconds interval(options.checkpointIntervalMs);
+    std::unique_lock<std::mutex> guard(c.lock);
+    while (!c.stop) {
+        if (c.wake.wait_for(guard, interval, [&] { return c.stop; })) break;
+        guard.unlock();
+        try {
+            checkpoint();
+        }
+        catch (...) {
+            //       ,    
+        }
+        guard.lock();
+    }
+}
+
+void NativeDb::stopCheckpoints()
+{
+    if (!options.inMemory) return;
+    {
+        std::lock_guard<std::mutex> guard(checkpointer->lock);
+        checkpointer->stop = true;
+    }
+    checkpointer->wake.notify_all();
+    if (checkpointer->timer.joinable()) checkpointer->timer.join();
+    try {
+        checkpoint();
+    }
+    catch (...) {
+        //   ;      checkpoint()  
+    }
+}
+
+// =====   =====
+
+static void json_string(std::ostream& out, const std::string& s)
+{
+    out << '"';
+    for (char ch : s) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        if (c == '"' || c == '\\') out << '\\' << ch;
+        else if (c == '\n') out << "\\n";
+        else if (c == '\t') out << "\\t";
+        else if (c < 0x20) {
+            static const char hex[] = "0123456789abcdef";
+            out << "\\u00" << hex[c >> 4] << hex[c & 15];
+        }
+        else out << ch;
+    }
+    out << '"';
+}
+
+std::string DbStats::json() const
+{
+    std::ostringstream out;
+    out.imbue(std::locale::classic());
+    out << "{\"seconds\":" << seconds << ",\"statements\":[";
+    for (std::size_t i = 0; i < statements.size(); ++i) {
+        const StatementStats& st = statements[i];
+        out << (i ? ",\n" : "\n") << "{\"sql\":";
+        json_string(out, st.sql);
+        out << ",\"calls\":" << st.calls << ",\"rows\":" << st.rows
+            << ",\"totalMs\":" << st.totalMs << ",\"p50Ms\":" << st.p50Ms
+            << ",\"p99Ms\":" << st.p99Ms << ",\"maxMs\":" << st.maxMs
+            << ",\"fullScan\":" << (st.fullScan ? "true" : "false") << ",\"plan\":[";
+        for (std::size_t j = 0; j < st.plan.size(); ++j) {
+            if (j) out << ',';
+            json_string(out, st.plan[j]);
+        }
+        out << "]}";
+    }
+    out << "\n]}\n";
+    return out.str();
+}
+
+DbStats NativeDb::stats()
+{
+    if (!profiler) throw std::logic_error("stats: profiling is off (DbOptions::profile)");
+    Profiler& p = *profiler;
+
+    //       : EXPLAIN  
+    std::vector<std::string> pending;
+    {
+        std::lock_guard<std::mutex> guard(p.lock);
+        for (auto& e : p.entries) {
+            if (!e.second->planned) pending.push_back(e.second->sql);
+        }
+    }
+    if (!pending.empty()) {
+        std::vector<std::vector<std::string>> plans(pending.size());
+        std::vector<char> scans(pending.size(), 0);
+        {
+            ReadLease lease(*this);
+            for (std::size_t i = 0; i < pending.size(); ++i) {
+                bool fullScan = false;
+                explain(lease.handle(), pending[i], plans[i], fullScan);
+                scans[i] = fullScan;
+            }
+        }
+        std::lock_guard<std::mutex> guard(p.lock);
+        for (std::size_t i = 0; i < pending.size(); ++i) {
+            auto it = p.entries.find(pending[i]);
+            if (it == p.entries.end() || it->second->planned) continue;
+            it->second->plan.swap(plans[i]);
+            it->second->fullScan = scans[i] != 0;
+            it->second->planned = true;
+        }
+    }
+
+    DbStats result;
+    std::lock_guard<std::mutex> guard(p.lock);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - p.since).count();
+    for (auto& item : p.entries) {
+        const Profiler::Entry& e = *item.second;
+        if (e.calls == 0) continue;
+        StatementStats st;
+        st.sql = e.sql;
+        st.calls = e.calls;
+        st.rows = e.rows;
+        st.totalMs = static_cast<double>(e.totalNs) / 1e6;
+        st.maxMs = static_cast<double>(e.maxNs) / 1e6;
+        st.p50Ms = percentile_ms(e.latency, e.calls, 0.50, e.maxNs);
+        st.p99Ms = percentile_ms(e.latency, e.calls, 0.99, e.maxNs);
+        st.plan = e.plan;
+        st.fullScan = e.fullScan;
+        result.statements.push_back(std::move(st));
+    }
+    std::sort(result.statements.begin(), result.statements.end(),
+        [](const StatementStats& a, const StatementStats& b) { return a.totalMs > b.totalMs; });
+    return result;
+}
+
+void NativeDb::resetStats()
+{
+    if (!profiler) throw std::logic_error("resetStats: profiling is off (DbOptions::profile)");
+    std::lock_guard<std::mutex> guard(profiler->lock);
+    for (auto& item : profiler->entries) {
+        Profiler::Entry& e = *item.second;
+        e.calls = 0;
+        e.rows = 0;
+        e.totalNs = 0;
+        e.maxNs = 0;
+        std::fill(e.latency.begin(), e.latency.end(), 0u);
+    }
+    profiler->since = std::chrono::steady_clock::now();
+}
+
+static void write_stats(const std::string& filename, const DbStats& stats)
+{
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("cannot create file: " + filename);
+    out << stats.json();
+    out.close();
+    if (!out) throw std::runtime_error("write failed: " + filename);
+}
+
+void NativeDb::runStatsDump()
+{
+    Profiler& p = *profiler;
+    const std::chrono::milliseconds interval(options.statsDumpIntervalMs);
+    std::unique_lock<std::mutex> guard(p.dumpLock);
+    while (!p.stop) {
+        if (p.wake.wait_for(guard, interval, [&] { return p.stop; })) break;
+        guard.unlock();
+        try {
+            write_stats(options.statsDumpPath, stats());
+        }
+        catch (...) {
+            //         
+        }
+        guard.lock();
+    }
+}
+
+void NativeDb::stopStatsDump()
+{
+    if (!profiler || options.statsDumpPath.empty()) return;
+    {
+        std::lock_guard<std::mutex> guard(profiler->dumpLock);
+        profiler->stop = true;
+    }
+    profiler->wake.notify_all();
+    if (profiler->timer.joinable()) profiler->timer.join();
+    try {
+        write_stats(options.statsDumpPath, stats());
+    }
+    catch (...) {
+        //   
+    }
+}
@@ -2,24 +2,567 @@
 #include <string>
 #include <vector>
 #include <tuple>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <functional>
+#include "Progress.h"
 
+// =====   =====
+
+struct MigrationOptions {
+    //      :     
+    std::size_t batchRows = 50000;
+};
+
+struct MigrationResult {
+    int version = 0;
+    std::string name;
+    double seconds = 0.0;
+    std::size_t rowsCopied = 0;
+    std::size_t batches = 0;
+};
+
+struct MigrationReport {
+    int fromVersion = 0;
+    int toVersion = 0;
+    std::vector<MigrationResult> applied;   // ,    
+};
+
+// =====   =====
+//
+// Default        SQLite. page_size 
+//     (  )   VACUUM.
+
+enum class JournalMode { Default, Delete, Truncate, Persist, Memory, Wal, Off };
+enum class SyncLevel { Default, Off, Normal, Full, Extra };
+enum class TempStore { Default, File, Memory };
+
+struct DbOptions {
+    JournalMode journalMode = JournalMode::Default;
+    SyncLevel synchronous = SyncLevel::Default;
+    std::int64_t mmapSize = -1;       // ; -1   , 0  
+    std::int64_t cacheSizeKiB = 0;    // 0   
+    int pageSize = 0;                 // 0   
+    TempStore tempStore = TempStore::Default;
+    int busyTimeoutMs = 0;            // 0  SQLITE_BUSY 
+    //      .  WAL:  JournalMode::Default
+    //   ,        
+    unsigned readerConnections = 0;
+    //    insertOrReplaceAsync:  ,
+    //   groupCommitRows    groupCommitWindowMs
+    //       
+    unsigned groupCommitWindowMs = 5;
+    std::size_t groupCommitRows = 1000;
+    //  ,     initialize()
+    MigrationOptions migration;
+    //    :  dbPath   ,  
+    //     (-  )  
+    // checkpointIntervalMs,  checkpoint()   .  
+    //     . WAL      
+    //  ,    
+    bool inMemory = false;
+    unsigned checkpointIntervalMs = 60000;        // 0   checkpoint()  
+    SyncLevel checkpointSync = SyncLevel::Full;   // synchronous   
+    //   WorkTypes  takeChangeset().  SQLite 
+    // SQLITE_ENABLE_SESSION  SQLITE_ENABLE_PREUPDATE_HOOK (    
+    //  sqlite3.c,   ),      
+    //  (FinalPay),    3.40   .  
+    //         
+    bool recordChanges = false;
+    //     stats():     
+    //  sqlite3_trace_v2   .     .
+    // statsDumpPath    statsDumpIntervalMs      stats()  JSON
+    bool profile = false;
+    std::string statsDumpPath;
+    unsigned statsDumpIntervalMs = 60000;
+
+    //    FULL:      
+    static DbOptions durable();
+    // WAL  NORMAL:       ,
+    //   ;  , mmap    4 
+    static DbOptions balanced();
+    //      :   ,  fsync
+    static DbOptions bulkLoad();
+};
+
+struct ImportOptions {
+    unsigned parserThreads = 0;   // 0    
+    std::size_t batchSize = 0;    //   ; 0     
+    char separator = 0;           // 0     
+    IProgressSink* progress = nullptr;
+    double progressInterval = 0.5;             //   
+    const CancellationToken* cancel = nullptr; //    
+    //   ,   ,    XXH64
+    //         .
+    //   WorkTypes   (   )
+    //  ,     . 
+    //     :   
+    //     
+    bool skipUnchanged = false;
+    std::size_t sortMemoryBytes = 256u << 20;  // syncFromFile:     
+    std::string sortTempDir;                   // syncFromFile:  ;    
+    bool bulkLoad = false;                     //    beginBulkLoad()/endBulkLoad()
+};
+
+struct ImportStats {
+    std::size_t rowsImported = 0;
+    std::size_t rowsSkipped = 0;
+    std::size_t rowsWritten = 0;      //    : rowsInserted + rowsUpdated (+ rowsDeleted)
+    std::size_t rowsUnchanged = 0;    //   ,  
+    std::size_t rowsInserted = 0;
+    std::size_t rowsUpdated = 0;
+    std::size_t rowsDeleted = 0;
+    bool fileUnchanged = false;       // skipUnchanged:   
+    std::uint64_t bytesProcessed = 0;
+    double seconds = 0.0;
+    double rowsPerSecond = 0.0;
+    double bytesPerSecond = 0.0;
+    unsigned parserThreads = 0;
+    //  ,   ,     (0..1)
+    double readerUtilization = 0.0;
+    double parserUtilization = 0.0;
+    double writerUtilization = 0.0;
+};
+
+//  upsert   
+enum class UpsertResult { Inserted, Updated, Unchanged };
+
+struct UpsertCounts {
+    std::size_t inserted = 0;
+    std::size_t updated = 0;
+    std::size_t unchanged = 0;   //  :    ,   
+
+    std::size_t total() const { return inserted + updated + unchanged; }
+    void add(UpsertResult r)
+    {
+        if (r == UpsertResult::Inserted) ++inserted;
+        else if (r == UpsertResult::Updated) ++updated;
+        else ++unchanged;
+    }
+};
+
+struct InsertOptions {
+    //    INSERT ... VALUES (...), (...); 1     .
+    // 256  = 768        SQLite (999)
+    std::size_t rowsPerStatement = 256;
+};
+
+// =====     =====
+
+enum class ImportIssueKind {
+    TooFewFields,     //        
+    InvalidNumber,    //      
+    DuplicateName,    //     
+    // ,   WorkTypeBase ( PayrollDepartment::loadFromFile);
+    //        
+    EmptyName,
+    InvalidBasePay,   //   <= 0
+    NegativeBonus
+};
+
+struct ImportIssue {
+    std::size_t line = 0;
+    unsigned column = 0;          //    1; 0   
+    ImportIssueKind kind = ImportIssueKind::TooFewFields;
+    std::size_t firstLine = 0;    //       
+};
+
+struct ValidationReport {
+    std::size_t rowsChecked = 0;
+    std::size_t rowsValid = 0;
+    std::size_t errorCount = 0;       //  ,  DuplicateName
+    std::size_t duplicateCount = 0;
+    std::vector<ImportIssue> issues;  //   ,   maxIssues
+    bool truncated = false;           //  ,    issues
+    double seconds = 0.0;
+
+    bool ok() const { return errorCount == 0; }
+    //   :      
+    std::string text() const;
+};
+
+struct ExportOptions {
+    IProgressSink* progress = nullptr;
+    double progressInterval = 0.5;
+    const CancellationToken* cancel = nullptr; //     
+    std::size_t arrowBatchRows = 65536;        //   RecordBatch  .arrow/.arrows
+};
+
+struct ExportStats {
+    std::size_t rowsExported = 0;
+    std::uint64_t bytesWritten = 0;   //  
+    double seconds = 0.0;
+    double rowsPerSecond = 0.0;
+    double bytesPerSecond = 0.0;
+};
+
+//   CSV   NativeDb::exportToFile: UTF-8 BOM,  
+//  (  ),   ;  
+//     4096 .     ShardedDb.
+// ,    finish() (, ), 
+class CsvExportWriter {
+public:
+    CsvExportWriter(const std::string& filename, std::size_t totalRows, const ExportOptions& options);
+    ~CsvExportWriter();
+
+    CsvExportWriter(const CsvExportWriter&) = delete;
+    CsvExportWriter& operator=(const CsvExportWriter&) = delete;
+
+    void append(std::string_view name, double basePay, double bonusPercent);
+    ExportStats finish();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+// =====   =====
+
+enum class PageOrder { Name, FinalPay };
+
+struct WorkTypeRow {
+    std::string name;
+    double basePay = 0.0;
+    double bonusPercent = 0.0;
+    double finalPay = 0.0;
+};
+
+//    ; valid == false   
+struct PageKey {
+    bool valid = false;
+    std::string name;
+    double finalPay = 0.0;
+};
+
+struct Page {
+    std::vector<WorkTypeRow> rows;
+    PageKey next;          //    getPage
+    bool hasMore = false;
+};
+
+//   FinalPay;  count == 0   
+struct PayStats {
+    std::size_t count = 0;
+    double sum = 0.0;
+    double average = 0.0;
+    double minPay = 0.0;
+    double maxPay = 0.0;
+};
+
+// =====     =====
+
+// name    SQLite      
+struct RowView {
+    std::string_view name;
+    double basePay = 0.0;
+    double bonusPercent = 0.0;
+};
+
+//   WorkTypes:  -    ,
+//   break  range-for   .  .
+class RowCursor {
+public:
+    class iterator {
+    public:
+        iterator() : cursor(nullptr) {}
+        const RowView& operator*() const { return cursor->current; }
+        const RowView* operator->() const { return &cursor->current; }
+        iterator& operator++()
+        {
+            if (!cursor->next()) cursor = nullptr;
+            return *this;
+        }
+        bool operator==(const iterator& other) const { return cursor == other.cursor; }
+        bool operator!=(const iterator& other) const { return cursor != other.cursor; }
+
+    private:
+        friend class RowCursor;
+        explicit iterator(RowCursor* cursor) : cursor(cursor) {}
+        RowCursor* cursor;
+    };
+
+    RowCursor(RowCursor&& other) noexcept;
+    RowCursor& operator=(RowCursor&& other) noexcept;
+    ~RowCursor();
+
+    //  ; false   
+    bool next();
+    const RowView& row() const { return current; }
+
+    //   begin()   ;    
+    iterator begin();
+    iterator end() { return iterator(); }
+
+private:
+    friend class NativeDb;
+    struct Impl;
+    explicit RowCursor(std::unique_ptr<Impl> impl);
+
+    std::unique_ptr<Impl> impl;
+    RowView current;
+    bool started;
+};
+
+// =====   changeset =====
+//
+// Changeset      (   Id) 
+//   SQLite. ,     ,
+//    Id,    .
+
+typedef std::vector<unsigned char> Changeset;
+
+enum class ChangeOp { Insert, Update, Delete };
+// Data   ,     ; NotFound   ;
+// Conflict     Id; Constraint    (UNIQUE Name)
+enum class ConflictKind { Data, NotFound, Conflict, Constraint, ForeignKey };
+// Replace    Data  Conflict,    Omit
+enum class ConflictAction { Omit, Replace, Abort };
+
+struct ChangeConflict {
+    ConflictKind kind = ConflictKind::Data;
+    ChangeOp op = ChangeOp::Insert;
+    std::int64_t id = 0;
+    std::string name;   // ,     
+};
+
+typedef std::function<ConflictAction(const ChangeConflict&)> ConflictHandler;
+
+struct ApplyStats {
+    std::size_t changes = 0;     //   changeset
+    std::size_t conflicts = 0;
+    std::size_t replaced = 0;
+    std::size_t omitted = 0;
+};
+
+//   : ,     
+//          synchronous = FULL, 
+//     NORMAL.  synchronous = OFF (  bulk-)
+//    :     .
+// std::future    ,   /clr-.
+class WriteTicket {
+public:
+    WriteTicket();
+
+    bool ready() const;
+    //  ;       std::runtime_error
+    void wait() const;
+
+    struct State;   //   NativeDb.cpp
+
+private:
+    friend class NativeDb;
+    std::shared_ptr<State> state;
+};
+
+// =====   =====
+
+struct BackupOptions {
+    //   :      
+    // pagesPerStep ,    pauseMs    .
+    //        ,   
+    int pagesPerStep = 100;
+    unsigned pauseMs = 10;
+    SyncLevel synchronous = SyncLevel::Default;   //   
+    IProgressSink* progress = nullptr;         //    
+    double progressInterval = 0.5;
+    const CancellationToken* cancel = nullptr; //  ,    
+};
+
+struct BackupStats {
+    int pagesTotal = 0;
+    int pagesCopied = 0;
+    int steps = 0;
+    int restarts = 0;        //   :    
+    double seconds = 0.0;
+};
+
+//  ,  backupTo();    
+class BackupJob {
+public:
+    BackupJob();
+
+    bool ready() const;
+    //   ;      
+    BackupStats wait() const;
+    void cancel();
+
+    struct State;   //   NativeDb.cpp
+
+private:
+    friend class NativeDb;
+    std::shared_ptr<State> state;
+};
+
+// =====   =====
+
+//      SQL (  ?,  ). 
+//      reset/finalize,       
+//  ,     .
+struct StatementStats {
+    std::string sql;
+    std::size_t calls = 0;
+    std::size_t rows = 0;        //     
+    double totalMs = 0.0;
+    double p50Ms = 0.0;          //   ,  ~6%
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+    // EXPLAIN QUERY PLAN   stats()   ;
+    //      
+    std::vector<std::string> plan;
+    bool fullScan = false;       //    SCAN   
+};
+
+struct DbStats {
+    double seconds = 0.0;                    //     resetStats()
+    std::vector<StatementStats> statements;  //   totalMs
+    std::string json() const;
+};
+
+// :      - 
+// ,  (getAll, )      
+// .          .
 class NativeDb {
 public:
-    explicit NativeDb(const std::string& dbPath);
+    explicit NativeDb(const std::string& dbPath, const DbOptions& options = DbOptions());
     ~NativeDb();
 
+    //     : migrate(options.migration)
     void initialize();
+    //      PRAGMA user_version; 
+    //      
+    MigrationReport migrate(const MigrationOptions& options = MigrationOptions());
+    int schemaVersion();
+    static int latestSchemaVersion();
+
+    //       (synchronous=OFF,
+    //    ,  )    .
+    //   ;      .
+    void beginBulkLoad();
+    void endBulkLoad();
 
     std::vector<std::tuple<std::string, double, double>> getAll();
+    //     FinalPay,   SQLite  
+    std::vector<WorkTypeRow> getByPayRange(double minPay, double maxPay, std::size_t limit = 0);
+    std::vector<WorkTypeRow> topByPay(std::size_t k);
+    PayStats payStats();
+    PayStats payStats(double minPay, double maxPay);
+    //      Name; false    
+    bool find(const std::string& name, WorkTypeRow& row);
+
+    //     : for (const RowView& r : db.rows())
+    //    (      )  
+    RowCursor rows(PageOrder orderBy = PageOrder::Name);
+    //   ,    OFFSET:   ,   
+    //   O(log n + limit),     
+    Page getPage(const PageKey& afterKey, std::size_t limit,
+        PageOrder orderBy = PageOrder::Name, bool descending = false);
     void clearTable();
+    // INSERT ... ON CONFLICT(Name) DO UPDATE:   
+    // Id    ,        
+    UpsertResult upsert(const std::string& name, double basePay, double bonusPercent);
+    //  ,  upsert();    INSERT OR REPLACE
     void insertOrReplace(const std::string& name, double basePay, double bonusPercent);
+    //  upsert:   (   ),
+    //   
+    UpsertCounts insertMany(const std::vector<std::tuple<std::string, double, double>>& rows,
+        const InsertOptions& options = InsertOptions());
+    //          
+    UpsertCounts insertMany(const std::string* names, const double* basePay, const double* bonusPercent,
+        std::size_t count, const InsertOptions& options = InsertOptions());
+    //      rows: DELETE   
+    //  ,         
+    UpsertCounts replaceAll(const std::vector<std::tuple<std::string, double, double>>& rows,
+        const InsertOptions& options = InsertOptions());
+    //      ,   
+    //    ;  fsync      
+    WriteTicket insertOrReplaceAsync(const std::string& name, double basePay, double bonusPercent);
+    //   ,     
+    void flushWrites();
+
+    //     ;    
+    // ImportedFiles      (. skipUnchanged)
+    ImportStats importFromFile(const std::string& filename,
+        const ImportOptions& options = ImportOptions());
+    std::size_t importIncremental(const std::string& filename);
+    //       :   
+    //  (,     )    ,
+    //    INSERT/UPDATE/DELETE.  
+    // ,    importFromFile, 
+    ImportStats syncFromFile(const std::string& filename,
+        const ImportOptions& options = ImportOptions());
+    //     ,   ,    
+    //        
+    ValidationReport validateFile(const std::string& filename,
+        const ImportOptions& options = ImportOptions(), std::size_t maxIssues = 1000);
+    // .arrow/.feather/.arrows   exportToArrow,   CSV
+    ExportStats exportToFile(const std::string& filename,
+        const ExportOptions& options = ExportOptions());
+    //  Arrow IPC;   ,    
+    ExportStats exportToArrow(const std::string& filename,
+        const ExportOptions& options = ExportOptions());
 
-    void importFromFile(const std::string& filename);
-    void exportToFile(const std::string& filename);
+    //      path   :  
+    //     sqlite3_backup_step.    
+    //     ;      .
+    //    ,     .
+    BackupJob backupTo(const std::string& path, const BackupOptions& options = BackupOptions());
+    // DbOptions::inMemory:    ,     
+    // ; false    .     
+    //          checkpoint() 
+    bool checkpoint();
+
+    //   ;  DbOptions::profile
+    DbStats stats();
+    //  ;  
+    void resetStats();
+
+    //  WorkTypes,        (
+    //   ),  changeset;     
+    //  .  DbOptions::recordChanges.
+    Changeset takeChangeset();
+    //  changeset  .  : Data  Conflict 
+    // Replace (   ), NotFound  Omit,   Abort.
+    // Abort      std::runtime_error.
+    ApplyStats applyChangeset(const Changeset& changes, const ConflictHandler& onConflict = ConflictHandler());
+    //  changeset'    ,       
+    static Changeset combineChangesets(const std::vector<Changeset>& parts);
+    static void saveChangeset(const std::string& filename, const Changeset& changes);
+    static Changeset loadChangeset(const std::string& filename);
 
 private:
+    friend class RowCursor;
+    struct ConnectionPool;
+    class ReadLease;
+    struct WriteQueue;
+    struct ChangeTracker;
+    struct BackupRunner;
+    struct Checkpointer;
+    struct Profiler;
+
     std::string path;
+    DbOptions options;
     struct sqlite3* dbHandle;
+    std::unique_ptr<ConnectionPool> pool;
+    std::unique_ptr<WriteQueue> writeQueue;
+    std::unique_ptr<ChangeTracker> changes;
+    std::unique_ptr<BackupRunner> backups;
+    std::unique_ptr<Checkpointer> checkpointer;
+    std::unique_ptr<Profiler> profiler;
+    int bulkDepth;
+    int savedSynchronous;
+    std::int64_t savedCacheSize;
+    int savedTempStore;
     void openDb();
     void closeDb();
+    struct sqlite3* openReader();
+    void runWriteQueue();
+    void stopWriteQueue();
+    void runBackup(std::shared_ptr<BackupJob::State> job);
+    void stopBackups();
+    void runCheckpoints();
+    void stopCheckpoints();
+    void runStatsDump();
+    void stopStatsDump();
 };
@@ -1,8 +1,11 @@
 #include "Payroll.h"
+#include "PayrollSnapshot.h"
+#include "FileIO.h"
+#include "CsvParser.h"
 
-#include <fstream>
-#include <sstream>
 #include <algorithm>
+#include <string_view>
+#include <unordered_set>
 
 // =====  =====
 
@@ -64,9 +67,59 @@ double WorkTypeBase::getFinalPay() const { return bonusStrategy->computePay(base
 
 // ===== PayrollDepartment =====
 
+static std::shared_ptr<IWorkType> make_work_type(const std::string& name, double basePay, double bonusPercent)
+{
+    std::shared_ptr<IBonusStrategy> strategy;
+    if (bonusPercent == 0.0)
+        strategy = std::make_shared<NoBonusStrategy>();
+    else
+        strategy = std::make_shared<PercentageBonusStrategy>(bonusPercent);
+    return std::make_shared<WorkTypeBase>(name, basePay, bonusPercent, strategy);
+}
+
 PayrollDepartment::PayrollDepartment() = default;
 
+//   ,    :   
+// .   ,   addWorkType,       
+static void validate_snapshot(const PayrollSnapshot& snap)
+{
+    std::unordered_set<std::string_view> names;
+    names.reserve(snap.size());
+    for (std::size_t i = 0; i < snap.size(); ++i) {
+        std::string_view name = snap.name(i);
+        auto row = [i] { return " (snapshot row " + std::to_string(i) + ")"; };
+        if (name.empty()) throw InvalidRateException("name must not be empty" + row());
+        if (snap.basePay(i) <= 0) throw InvalidRateException("base pay must be > 0" + row());
+        if (snap.bonusPercent(i) < 0) throw InvalidRateException("bonus >= 0" + row());
+        if (!names.insert(name).second)
+            throw DuplicateWorkTypeException("work type '" + std::string(name) + "' already exists" + row());
+    }
+}
+
+void PayrollDepartment::materialize() const {
+    if (!snapshot) return;
+    //      ,   
+    validate_snapshot(*snapshot);
+    std::shared_ptr<const PayrollSnapshot> snap = snapshot;
+    snapshot.reset();
+    workTypes.clear();
+    workTypes.reserve(snap->size());
+    for (std::size_t i = 0; i < snap->size(); ++i)
+        workTypes.push_back(std::make_shared<SnapshotWorkType>(snap, i));
+}
+
+//       :  
+// ,     (Windows     )
+void PayrollDepartment::detachSnapshot() const {
+    materialize();
+    for (auto& w : workTypes) {
+        if (dynamic_cast<const SnapshotWorkType*>(w.get()))
+            w = make_work_type(w->getName(), w->getBasePay(), w->getBonusPercent());
+    }
+}
+
 bool PayrollDepartment::existsWorkType(const std::string& name) const {
+    materialize();
     for (const auto& w : workTypes)
         if (w->getName() == name) return true;
     return false;
@@ -81,14 +134,7 @@ void PayrollDepartment::addWorkType(const std::string& name,
             "work type '" + name + "' already exists");
     }
 
-    std::shared_ptr<IBonusStrategy> strategy;
-    if (bonusPercent == 0.0)
-        strategy = std::make_shared<NoBonusStrategy>();
-    else
-        strategy = std::make_shared<PercentageBonusStrategy>(bonusPercent);
-
-    workTypes.push_back(
-        std::make_shared<WorkTypeBase>(name, basePay, bonusPercent, strategy));
+    workTypes.push_back(make_work_type(name, basePay, bonusPercent));
 }
 
 void PayrollDepartment::updateWorkType(std::size_t index,
@@ -96,6 +142,7 @@ void PayrollDepartment::updateWorkType(std::size_t index,
     double basePay,
     double bonusPercent)
 {
+    materialize();
     if (index >= workTypes.size())
         throw PayrollException("index out of range");
 
@@ -104,105 +151,120 @@ void PayrollDepartment::updateWorkType(std::size_t index,
             throw DuplicateWorkTypeException("work type '" + name + "' already exists");
     }
 
-    std::shared_ptr<IBonusStrategy> strategy;
-    if (bonusPercent == 0.0)
-        strategy = std::make_shared<NoBonusStrategy>();
-    else
-        strategy = std::make_shared<PercentageBonusStrategy>(bonusPercent);
-
-    workTypes[index] =
-        std::make_shared<WorkTypeBase>(name, basePay, bonusPercent, strategy);
+    workTypes[index] = make_work_type(name, basePay, bonusPercent);
 }
 
 void PayrollDepartment::removeWorkType(std::size_t index)
 {
+    materialize();
     if (index >= workTypes.size())
         throw PayrollException("index out of range");
     workTypes.erase(workTypes.begin() + index);
 }
 
 void PayrollDepartment::clear() {
+    snapshot.reset();
     workTypes.clear();
 }
 
 const std::vector<std::shared_ptr<IWorkType>>&
 PayrollDepartment::getWorkTypes() const
 {
+    materialize();
     return workTypes;
 }
 
+std::size_t PayrollDepartment::size() const
+{
+    return snapshot ? snapshot->size() : workTypes.size();
+}
+
 double PayrollDepartment::calculateAveragePay() const
 {
-    if (workTypes.empty())
+    if (size() == 0)
         throw EmptyWorkListException("cannot calculate average");
 
     double sum = 0.0;
+    if (snapshot) {
+        //     ,   
+        for (std::size_t i = 0; i < snapshot->size(); ++i) sum += snapshot->finalPay(i);
+        return sum / static_cast<double>(snapshot->size());
+    }
+
     for (const auto& w : workTypes) sum += w->getFinalPay();
     return sum / static_cast<double>(workTypes.size());
 }
 
 // =====  =====
 
-static std::string trim(const std::string& s)
-{
-    std::size_t start = s.find_first_not_of(" \t\r\n");
-    if (start == std::string::npos) return std::string();
-    std::size_t end = s.find_last_not_of(" \t\r\n");
-    return s.substr(start, end - start + 1);
-}
-
 void PayrollDepartment::saveToFile(const std::string& filename) const
 {
-    std::ofstream out(filename.c_str());
-    if (!out) throw PayrollException("cannot open file: " + filename);
+    materialize();
+    std::unique_ptr<OutputFile> file;
+    try { file.reset(new OutputFile(filename)); }
+    catch (const std::exception& ex) { throw PayrollException(ex.what()); }
+    std::ostream& out = file->stream();
 
     for (const auto& w : workTypes) {
-        out << w->getName() << ';'
+        std::string name = w->getName();
+        if (name.find_first_of(";,\t\"\r\n") != std::string::npos) {
+            //          
+            //   RFC 4180,      
+            std::string quoted = "\"";
+            for (char c : name) {
+                if (c == '"') quoted += '"';
+                quoted += c;
+            }
+            name = quoted + '"';
+        }
+        out << name << ';'
             << w->getBasePay() << ';'
             << w->getBonusPercent() << '\n';
     }
+    file->close();
 }
 
 void PayrollDepartment::loadFromFile(const std::string& filename)
 {
-    std::ifstream in(filename.c_str());
-    if (!in) throw PayrollException("cannot open file: " + filename);
-
-    workTypes.clear();
-
-    std::string line;
-    std::size_t lineNo = 0;
-
-    while (std::getline(in, line)) {
-        ++lineNo;
-        line = trim(line);
-        if (line.empty()) continue;
-
-        std::istringstream iss(line);
-        std::string name, baseStr, bonusStr;
-        if (!std::getline(iss, name, ';') ||
-            !std::getline(iss, baseStr, ';') ||
-            !std::getline(iss, bonusStr))
-        {
-            throw PayrollException("invalid format at line " +
-                std::to_string(lineNo));
-        }
-
-        name = trim(name);
-        baseStr = trim(baseStr);
-        bonusStr = trim(bonusStr);
-
-        double basePay = std::stod(baseStr);
-        double bonusPercent = std::stod(bonusStr);
-
+    std::unique_ptr<InputFile> file;
+    try { file.reset(new InputFile(filename)); }
+    catch (const std::exception& ex) { throw PayrollException(ex.what()); }
+    std::istream& in = file->stream();
+
+    clear();
+
+    CsvParser csv(in);
+    std::string name;
+    while (csv.next()) {
+        double basePay, bonusPercent;
+        if (csv.size() < 3)
+            throw PayrollException("invalid format at line " + std::to_string(csv.line()));
+        if (!csvToDouble(csv[1], basePay) || !csvToDouble(csv[2], bonusPercent))
+            throw PayrollException("invalid number at line " + std::to_string(csv.line()));
+        name.assign(csv[0].data(), csv[0].size());
         addWorkType(name, basePay, bonusPercent);
     }
 }
 
+void PayrollDepartment::saveSnapshot(const std::string& filename) const
+{
+    detachSnapshot();
+    PayrollSnapshot::write(filename, workTypes);
+}
+
+void PayrollDepartment::loadSnapshot(const std::string& filename)
+{
+    //     ;   materialize()
+    std::shared_ptr<PayrollSnapshot> snap = PayrollSnapshot::open(filename);
+    workTypes.clear();
+    snapshot = snap;
+}
+
 // =====  =====
 
 void PayrollDepartment::sortByName(bool ascending)
 {
+    materialize();
     std::sort(workTypes.begin(), workTypes.end(),
         [ascending](const std::shared_ptr<IWorkType>& a,
             const std::shared_ptr<IWorkType>& b)
@@ -214,6 +276,7 @@ void PayrollDepartment::sortByName(bool ascending)
 
 void PayrollDepartment::sortByFinalPay(bool ascending)
 {
+    materialize();
     std::sort(workTypes.begin(), workTypes.end(),
         [ascending](const std::shared_ptr<IWorkType>& a,
             const std::shared_ptr<IWorkType>& b)
@@ -80,11 +80,17 @@ public:
 
 // =====    =====
 
+class PayrollSnapshot;
+
 class PayrollDepartment {
 private:
-    std::vector<std::shared_ptr<IWorkType>> workTypes;
+    //  loadSnapshot      
+    mutable std::vector<std::shared_ptr<IWorkType>> workTypes;
+    mutable std::shared_ptr<PayrollSnapshot> snapshot;
 
     bool existsWorkType(const std::string& name) const;
+    void materialize() const;
+    void detachSnapshot() const;
 
 public:
     PayrollDepartment();
@@ -109,6 +115,13 @@ public:
     void saveToFile(const std::string& filename) const;
     void loadFromFile(const std::string& filename);
 
+    void saveSnapshot(const std::string& filename) const;
+    //    ;    
+    //    (getWorkTypes, , , )
+    void loadSnapshot(const std::string& filename);
+
+    std::size_t size() const;
+
     void sortByName(bool ascending);
     void sortByFinalPay(bool ascending);
 };
@@ -0,0 +1,297 @@
+#include "PayrollSnapshot.h"
+
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char SnapshotMagic[8] = { 'P', 'A', 'Y', 'S', 'N', 'A', 'P', '\0' };
+
+// =====   (FNV-1a 64) =====
+
+static const std::uint64_t FnvOffset = 1469598103934665603ULL;
+static const std::uint64_t FnvPrime = 1099511628211ULL;
+
+static std::uint64_t fnv1a(std::uint64_t h, const void* data, std::size_t len)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < len; ++i) {
+        h ^= p[i];
+        h *= FnvPrime;
+    }
+    return h;
+}
+
+static std::uint64_t headerChecksumOf(const SnapshotHeader& h)
+{
+    return fnv1a(FnvOffset, &h, offsetof(SnapshotHeader, headerChecksum));
+}
+
+static std::uint64_t align8(std::uint64_t v)
+{
+    return (v + 7) & ~static_cast<std::uint64_t>(7);
+}
+
+//  [offset, offset + length)  ,    
+static bool fits(std::uint64_t offset, std::uint64_t length, std::uint64_t size)
+{
+    return offset <= size && length <= size - offset;
+}
+
+//     target 
+static void replace_file(const std::string& from, const std::string& target)
+{
+#ifdef _WIN32
+    bool ok = MoveFileExA(from.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    bool ok = std::rename(from.c_str(), target.c_str()) == 0;
+#endif
+    if (!ok) {
+        std::remove(from.c_str());
+        throw PayrollException("cannot replace file: " + target);
+    }
+}
+
+// =====     =====
+
+struct PayrollSnapshot::Mapping {
+    const char* data = nullptr;
+    std::uint64_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE view = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    explicit Mapping(const std::string& filename)
+    {
+#ifdef _WIN32
+        file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            throw PayrollException("cannot open file: " + filename);
+        LARGE_INTEGER len;
+        if (!GetFileSizeEx(file, &len)) {
+            close();
+            throw PayrollException("cannot stat file: " + filename);
+        }
+        size = static_cast<std::uint64_t>(len.QuadPart);
+        if (size == 0) return;
+        view = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (view) data = static_cast<const char*>(MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0));
+#else
+        fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw PayrollException("cannot open file: " + filename);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close();
+            throw PayrollException("cannot stat file: " + filename);
+        }
+        size = static_cast<std::uint64_t>(st.st_size);
+        if (size == 0) return;
+        void* p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            data = static_cast<const char*>(p);
+            //     ,     
+            madvise(p, size, MADV_RANDOM);
+        }
+#endif
+        if (!data) {
+            close();
+            throw PayrollException("cannot map file: " + filename);
+        }
+    }
+
+    ~Mapping() { close(); }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (view) CloseHandle(view);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        view = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data) munmap(const_cast<char*>(data), size);
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+        data = nullptr;
+    }
+};
+
+// ===== PayrollSnapshot =====
+
+PayrollSnapshot::PayrollSnapshot()
+    : header(nullptr), basePays(nullptr), bonuses(nullptr),
+    nameOffsets(nullptr), nameHeap(nullptr) {}
+
+PayrollSnapshot::~PayrollSnapshot() = default;
+
+std::shared_ptr<PayrollSnapshot> PayrollSnapshot::open(const std::string& filename)
+{
+    std::shared_ptr<PayrollSnapshot> snap(new PayrollSnapshot());
+    snap->mapping.reset(new Mapping(filename));
+
+    const Mapping& m = *snap->mapping;
+    if (m.size < sizeof(SnapshotHeader))
+        throw PayrollException("snapshot is truncated: " + filename);
+
+    const SnapshotHeader* h = reinterpret_cast<const SnapshotHeader*>(m.data);
+    if (std::memcmp(h->magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0)
+        throw PayrollException("not a payroll snapshot: " + filename);
+    if (h->version != FormatVersion)
+        throw PayrollException("unsupported snapshot version " + std::to_string(h->version));
+    if (h->headerSize != sizeof(SnapshotHeader) || h->headerChecksum != headerChecksumOf(*h))
+        throw PayrollException("snapshot header is corrupted: " + filename);
+
+    // rowCount        
+    if (h->fileSize != m.size || h->rowCount > m.size / sizeof(double))
+        throw PayrollException("snapshot is truncated: " + filename);
+    const std::uint64_t colBytes = h->rowCount * sizeof(double);
+    if (!fits(h->basePayOffset, colBytes, m.size) ||
+        !fits(h->bonusOffset, colBytes, m.size) ||
+        !fits(h->nameOffsetsOffset, (h->rowCount + 1) * sizeof(std::uint64_t), m.size) ||
+        !fits(h->heapOffset, h->heapSize, m.size))
+    {
+        throw PayrollException("snapshot is truncated: " + filename);
+    }
+    if ((h->basePayOffset | h->bonusOffset | h->nameOffsetsOffset) % 8 != 0)
+        throw PayrollException("snapshot header is corrupted: " + filename);
+
+    snap->header = h;
+    snap->basePays = reinterpret_cast<const double*>(m.data + h->basePayOffset);
+    snap->bonuses = reinterpret_cast<const double*>(m.data + h->bonusOffset);
+    snap->nameOffsets = reinterpret_cast<const std::uint64_t*>(m.data + h->nameOffsetsOffset);
+    snap->nameHeap = m.data + h->heapOffset;
+    return snap;
+}
+
+void PayrollSnapshot::write(const std::string& filename,
+    const std::vector<std::shared_ptr<IWorkType>>& items)
+{
+    //       : items   
+    //    ,    ,   
+    const std::string temp = filename + ".tmp";
+    std::ofstream out(temp.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out) throw PayrollException("cannot open file: " + temp);
+
+    SnapshotHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, SnapshotMagic, sizeof(SnapshotMagic));
+    h.version = FormatVersion;
+    h.headerSize = sizeof(SnapshotHeader);
+    h.rowCount = items.size();
+
+    std::vector<std::string> names;
+    names.reserve(items.size());
+    std::uint64_t heapSize = 0;
+    for (const auto& w : items) {
+        names.push_back(w->getName());
+        heapSize += names.back().size();
+    }
+
+    const std::uint64_t colBytes = h.rowCount * sizeof(double);
+    h.basePayOffset = align8(sizeof(SnapshotHeader));
+    h.bonusOffset = h.basePayOffset + colBytes;
+    h.nameOffsetsOffset = h.bonusOffset + colBytes;
+    h.heapOffset = h.nameOffsetsOffset + (h.rowCount + 1) * sizeof(std::uint64_t);
+    h.heapSize = heapSize;
+    h.fileSize = h.heapOffset + heapSize;
+
+    //    ,     
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+    std::uint64_t sum = FnvOffset;
+    std::vector<char> buf;
+    buf.reserve(1 << 16);
+    auto flush = [&]() {
+        sum = fnv1a(sum, buf.data(), buf.size());
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        buf.clear();
+    };
+    auto put = [&](const void* p, std::size_t n) {
+        if (buf.size() + n > buf.capacity()) flush();
+        const char* c = static_cast<const char*>(p);
+        buf.insert(buf.end(), c, c + n);
+    };
+
+    for (const auto& w : items) { double v = w->getBasePay(); put(&v, sizeof(v)); }
+    for (const auto& w : items) { double v = w->getBonusPercent(); put(&v, sizeof(v)); }
+
+    std::uint64_t off = 0;
+    put(&off, sizeof(off));
+    for (const auto& n : names) { off += n.size(); put(&off, sizeof(off)); }
+    for (const auto& n : names) {
+        if (!n.empty()) put(n.data(), n.size());
+    }
+    flush();
+
+    h.dataChecksum = sum;
+    h.headerChecksum = headerChecksumOf(h);
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.close();
+    if (!out) {
+        std::remove(temp.c_str());
+        throw PayrollException("write failed: " + filename);
+    }
+    replace_file(temp, filename);
+}
+
+std::size_t PayrollSnapshot::size() const
+{
+    return static_cast<std::size_t>(header->rowCount);
+}
+
+std::string_view PayrollSnapshot::name(std::size_t index) const
+{
+    std::uint64_t a = nameOffsets[index];
+    std::uint64_t b = nameOffsets[index + 1];
+    if (a > b || b > header->heapSize)
+        throw PayrollException("snapshot name table is corrupted");
+    return std::string_view(nameHeap + a, static_cast<std::size_t>(b - a));
+}
+
+double PayrollSnapshot::basePay(std::size_t index) const { return basePays[index]; }
+double PayrollSnapshot::bonusPercent(std::size_t index) const { return bonuses[index]; }
+
+double PayrollSnapshot::finalPay(std::size_t index) const
+{
+    return basePays[index] * (1.0 + bonuses[index] / 100.0);
+}
+
+bool PayrollSnapshot::verify() const
+{
+    const char* base = mapping->data + header->headerSize;
+    std::uint64_t len = header->fileSize - header->headerSize;
+    return fnv1a(FnvOffset, base, static_cast<std::size_t>(len)) == header->dataChecksum;
+}
+
+// ===== SnapshotWorkType =====
+
+SnapshotWorkType::SnapshotWorkType(std::shared_ptr<const PayrollSnapshot> snapshot, std::size_t index)
+    : snapshot(snapshot), index(index) {}
+
+std::string SnapshotWorkType::getName() const { return std::string(snapshot->name(index)); }
+double SnapshotWorkType::getBasePay() const { return snapshot->basePay(index); }
+double SnapshotWorkType::getBonusPercent() const { return snapshot->bonusPercent(index); }
+double SnapshotWorkType::getFinalPay() const { return snapshot->finalPay(index); }
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Payroll.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+
+// =====    =====
+//
+//  (little-endian,     8 ):
+//   SnapshotHeader
+//   double   basePay[rowCount]
+//   double   bonusPercent[rowCount]
+//   uint64_t nameOffsets[rowCount + 1]      
+//   char     nameHeap[heapSize]             
+//
+// headerChecksum   , dataChecksum    verify(),
+//      .
+
+struct SnapshotHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint64_t rowCount;
+    std::uint64_t basePayOffset;
+    std::uint64_t bonusOffset;
+    std::uint64_t nameOffsetsOffset;
+    std::uint64_t heapOffset;
+    std::uint64_t heapSize;
+    std::uint64_t fileSize;
+    std::uint64_t dataChecksum;
+    std::uint64_t headerChecksum;
+};
+
+class PayrollSnapshot {
+public:
+    static const std::uint32_t FormatVersion = 1;
+
+    static std::shared_ptr<PayrollSnapshot> open(const std::string& filename);
+    static void write(const std::string& filename,
+        const std::vector<std::shared_ptr<IWorkType>>& items);
+
+    ~PayrollSnapshot();
+
+    PayrollSnapshot(const PayrollSnapshot&) = delete;
+    PayrollSnapshot& operator=(const PayrollSnapshot&) = delete;
+
+    std::size_t size() const;
+    std::string_view name(std::size_t index) const;
+    double basePay(std::size_t index) const;
+    double bonusPercent(std::size_t index) const;
+    double finalPay(std::size_t index) const;
+
+    //      (  )
+    bool verify() const;
+
+private:
+    PayrollSnapshot();
+
+    struct Mapping;
+    std::unique_ptr<Mapping> mapping;
+
+    const SnapshotHeader* header;
+    const double* basePays;
+    const double* bonuses;
+    const std::uint64_t* nameOffsets;
+    const char* nameHeap;
+};
+
+//  ,      
+class SnapshotWorkType : public IWorkType {
+private:
+    std::shared_ptr<const PayrollSnapshot> snapshot;
+    std::size_t index;
+public:
+    SnapshotWorkType(std::shared_ptr<const PayrollSnapshot> snapshot, std::size_t index);
+
+    std::string getName() const override;
+    double getBasePay() const override;
+    double getBonusPercent() const override;
+    double getFinalPay() const override;
+};
@@ -0,0 +1,82 @@
+#include "Progress.h"
+
+#include <atomic>
+#include <chrono>
+
+static double monotonicSeconds()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+OperationCancelledException::OperationCancelledException()
+    : std::runtime_error("operation cancelled") {}
+
+// ===== CancellationToken =====
+
+struct CancellationToken::State {
+    std::atomic<bool> flag;
+    State() : flag(false) {}
+};
+
+CancellationToken::CancellationToken() : state(std::make_shared<State>()) {}
+
+void CancellationToken::cancel() { state->flag.store(true, std::memory_order_release); }
+void CancellationToken::reset() { state->flag.store(false, std::memory_order_release); }
+bool CancellationToken::cancelled() const { return state->flag.load(std::memory_order_acquire); }
+
+void CancellationToken::check() const
+{
+    if (cancelled()) throw OperationCancelledException();
+}
+
+// ===== ProgressMeter =====
+
+ProgressMeter::ProgressMeter(IProgressSink* sink, double intervalSeconds, std::uint64_t bytesTotal,
+    std::size_t rowsTotal)
+    : sink(sink), interval(intervalSeconds), start(monotonicSeconds()), lastReport(start),
+    bytesTotal(bytesTotal), rowsTotal(rowsTotal), bytes(0), rows(0), rejected(0) {}
+
+void ProgressMeter::update(std::uint64_t b, std::size_t r, std::size_t rej)
+{
+    bytes = b;
+    rows = r;
+    rejected = rej;
+    if (!sink) return;
+    double now = monotonicSeconds();
+    if (now - lastReport < interval) return;
+    lastReport = now;
+    sink->onProgress(make());
+}
+
+ProgressInfo ProgressMeter::finish()
+{
+    if (bytesTotal == 0) bytesTotal = bytes;
+    ProgressInfo info = make();
+    if (sink) sink->onProgress(info);
+    return info;
+}
+
+ProgressInfo ProgressMeter::make() const
+{
+    ProgressInfo info;
+    info.bytesProcessed = bytes;
+    info.bytesTotal = bytesTotal;
+    info.rowsProcessed = rows;
+    info.rowsTotal = rowsTotal;
+    info.rowsRejected = rejected;
+    info.elapsedSeconds = monotonicSeconds() - start;
+    if (info.elapsedSeconds > 0.0) {
+        info.rowsPerSecond = rows / info.elapsedSeconds;
+        info.bytesPerSecond = bytes / info.elapsedSeconds;
+    }
+    if (bytesTotal > 0 && bytes > 0) {
+        double left = bytesTotal > bytes ? static_cast<double>(bytesTotal - bytes) : 0.0;
+        info.etaSeconds = info.bytesPerSecond > 0.0 ? left / info.bytesPerSecond : -1.0;
+    }
+    else if (rowsTotal > 0 && rows > 0) {
+        double left = rowsTotal > rows ? static_cast<double>(rowsTotal - rows) : 0.0;
+        info.etaSeconds = left / info.rowsPerSecond;
+    }
+    return info;
+}
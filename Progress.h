@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+// =====      =====
+
+struct ProgressInfo {
+    std::uint64_t bytesProcessed = 0;
+    std::uint64_t bytesTotal = 0;      // 0   
+    std::size_t rowsProcessed = 0;
+    std::size_t rowsTotal = 0;         // 0     
+    std::size_t rowsRejected = 0;
+    double elapsedSeconds = 0.0;
+    double rowsPerSecond = 0.0;
+    double bytesPerSecond = 0.0;
+    double etaSeconds = -1.0;          // -1   
+};
+
+class IProgressSink {
+public:
+    virtual ~IProgressSink() {}
+    virtual void onProgress(const ProgressInfo& info) = 0;
+};
+
+class OperationCancelledException : public std::runtime_error {
+public:
+    OperationCancelledException();
+};
+
+//  ;    , cancel()     
+class CancellationToken {
+public:
+    CancellationToken();
+
+    void cancel();
+    void reset();
+    bool cancelled() const;
+    //  OperationCancelledException,   
+    void check() const;
+
+private:
+    struct State;
+    std::shared_ptr<State> state;
+};
+
+//    ETA   sink  ,    interval 
+class ProgressMeter {
+public:
+    ProgressMeter(IProgressSink* sink, double intervalSeconds, std::uint64_t bytesTotal,
+        std::size_t rowsTotal = 0);
+
+    void update(std::uint64_t bytes, std::size_t rows, std::size_t rejected);
+    //       (,   )
+    void setBytesTotal(std::uint64_t total) { bytesTotal = total; }
+    //  ,   
+    ProgressInfo finish();
+
+private:
+    ProgressInfo make() const;
+
+    IProgressSink* sink;
+    double interval;
+    double start;
+    double lastReport;
+    std::uint64_t bytesTotal;
+    std::size_t rowsTotal;
+    std::uint64_t bytes;
+    std::size_t rows;
+    std::size_t rejected;
+};
@@ -0,0 +1,516 @@
+#include "RawFile.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#include <cstdio>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define PAYROLL_HAVE_URING 1
+#endif
+#endif
+#endif
+
+namespace {
+
+const std::size_t BlockSize = 1 << 20;
+const unsigned Depth = 4;
+
+#ifndef _WIN32
+
+void pwriteAll(int fd, const char* data, std::size_t len, std::uint64_t offset)
+{
+    while (len > 0) {
+        ssize_t n = ::pwrite(fd, data, len, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("write failed");
+        }
+        data += n;
+        len -= static_cast<std::size_t>(n);
+        offset += static_cast<std::uint64_t>(n);
+    }
+}
+
+std::size_t preadSome(int fd, char* dst, std::size_t cap, std::uint64_t offset)
+{
+    for (;;) {
+        ssize_t n = ::pread(fd, dst, cap, static_cast<off_t>(offset));
+        if (n >= 0) return static_cast<std::size_t>(n);
+        if (errno != EINTR) throw std::runtime_error("read failed");
+    }
+}
+
+#endif
+
+#ifdef PAYROLL_HAVE_URING
+
+//     io_uring
+class Uring {
+public:
+    Uring() : fd(-1), sqPtr(MAP_FAILED), cqPtr(MAP_FAILED), sqSize(0), cqSize(0),
+        sqes(static_cast<io_uring_sqe*>(MAP_FAILED)), sqesSize(0), localTail(0), submitted(0) {}
+
+    ~Uring()
+    {
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqPtr != MAP_FAILED && cqPtr != sqPtr) munmap(cqPtr, cqSize);
+        if (sqPtr != MAP_FAILED) munmap(sqPtr, sqSize);
+        if (fd >= 0) ::close(fd);
+    }
+
+    bool init(unsigned entries)
+    {
+        io_uring_params p;
+        std::memset(&p, 0, sizeof(p));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+        if (fd < 0) return false;
+
+        sqSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cqSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) sqSize = cqSize = sqSize > cqSize ? sqSize : cqSize;
+
+        sqPtr = mmap(nullptr, sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqPtr == MAP_FAILED) return false;
+        cqPtr = single ? sqPtr
+            : mmap(nullptr, cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqPtr == MAP_FAILED) return false;
+        sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(
+            mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) return false;
+
+        char* sq = static_cast<char*>(sqPtr);
+        sqHead = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sqEntries = p.sq_entries;
+        sqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        char* cq = static_cast<char*>(cqPtr);
+        cqHead = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        localTail = submitted = *sqTail;
+        return true;
+    }
+
+    void queue(std::uint8_t opcode, int file, const iovec* iov, std::uint64_t offset, std::uint64_t tag)
+    {
+        unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (localTail - head >= sqEntries) throw std::runtime_error("io_uring: submission queue is full");
+        unsigned idx = localTail & *sqMask;
+        io_uring_sqe* sqe = &sqes[idx];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode;
+        sqe->fd = file;
+        sqe->addr = reinterpret_cast<std::uint64_t>(iov);
+        sqe->len = 1;
+        sqe->off = offset;
+        sqe->user_data = tag;
+        sqArray[idx] = idx;
+        ++localTail;
+    }
+
+    //        waitNr 
+    void enter(unsigned waitNr)
+    {
+        __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+        unsigned toSubmit = localTail - submitted;
+        while (toSubmit > 0 || waitNr > 0) {
+            long rc = syscall(__NR_io_uring_enter, fd, toSubmit, waitNr,
+                waitNr ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (rc < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error("io_uring: enter failed");
+            }
+            submitted += static_cast<unsigned>(rc);
+            toSubmit -= static_cast<unsigned>(rc);
+            if (toSubmit == 0) break;
+        }
+    }
+
+    bool reap(std::uint64_t& tag, int& res)
+    {
+        unsigned head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) return false;
+        const io_uring_cqe& cqe = cqes[head & *cqMask];
+        tag = cqe.user_data;
+        res = cqe.res;
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    int fd;
+    void* sqPtr;
+    void* cqPtr;
+    std::size_t sqSize;
+    std::size_t cqSize;
+    io_uring_sqe* sqes;
+    std::size_t sqesSize;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned sqEntries;
+    unsigned* sqArray;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    io_uring_cqe* cqes;
+    unsigned localTail;
+    unsigned submitted;
+};
+
+#endif
+
+struct Slot {
+    std::vector<char> buf;
+    std::size_t len = 0;
+    std::size_t pos = 0;
+    std::uint64_t offset = 0;
+    bool busy = false;
+#ifndef _WIN32
+    iovec iov;
+#endif
+};
+
+} // namespace
+
+// ===== RawWriter =====
+
+#ifdef _WIN32
+
+struct RawWriter::Impl {
+    std::FILE* file;
+
+    explicit Impl(const std::string& filename) : file(std::fopen(filename.c_str(), "wb"))
+    {
+        if (!file) throw std::runtime_error("cannot open file: " + filename);
+        std::setvbuf(file, nullptr, _IOFBF, BlockSize);
+    }
+    ~Impl() { if (file) std::fclose(file); }
+
+    void write(const char* data, std::size_t len)
+    {
+        if (len && std::fwrite(data, 1, len, file) != len)
+            throw std::runtime_error("write failed");
+    }
+
+    void close()
+    {
+        if (!file) return;
+        int rc = std::fclose(file);
+        file = nullptr;
+        if (rc != 0) throw std::runtime_error("write failed");
+    }
+
+    bool async() const { return false; }
+};
+
+#else
+
+//      BlockSize;  Depth    
+struct RawWriter::Impl {
+    int fd;
+    Slot slots[Depth];
+    unsigned cur;
+    std::uint64_t offset;
+#ifdef PAYROLL_HAVE_URING
+    Uring ring;
+    bool useRing;
+#endif
+
+    explicit Impl(const std::string& filename) : cur(0), offset(0)
+    {
+        fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) throw std::runtime_error("cannot open file: " + filename);
+        for (Slot& s : slots) s.buf.resize(BlockSize);
+#ifdef PAYROLL_HAVE_URING
+        useRing = ring.init(Depth);
+#endif
+    }
+
+    ~Impl()
+    {
+        try { drain(); }
+        catch (...) {}
+        if (fd >= 0) ::close(fd);
+    }
+
+    void write(const char* data, std::size_t len)
+    {
+        while (len > 0) {
+            Slot& s = slots[cur];
+            wait(s);
+            std::size_t n = BlockSize - s.len;
+            if (n > len) n = len;
+            std::memcpy(s.buf.data() + s.len, data, n);
+            s.len += n;
+            data += n;
+            len -= n;
+            if (s.len == BlockSize) {
+                submit(s);
+                cur = (cur + 1) % Depth;
+            }
+        }
+    }
+
+    void submit(Slot& s)
+    {
+        s.offset = offset;
+        offset += s.len;
+#ifdef PAYROLL_HAVE_URING
+        if (useRing) {
+            s.iov.iov_base = s.buf.data();
+            s.iov.iov_len = s.len;
+            s.busy = true;
+            ring.queue(IORING_OP_WRITEV, fd, &s.iov, s.offset, static_cast<std::uint64_t>(&s - slots));
+            ring.enter(0);
+            return;
+        }
+#endif
+        pwriteAll(fd, s.buf.data(), s.len, s.offset);
+        s.len = 0;
+    }
+
+    void wait(Slot& s)
+    {
+#ifdef PAYROLL_HAVE_URING
+        while (s.busy) {
+            ring.enter(1);
+            std::uint64_t tag;
+            int res;
+            while (ring.reap(tag, res)) {
+                Slot& done = slots[tag];
+                done.busy = false;
+                if (res < 0) throw std::runtime_error("write failed");
+                //    
+                std::size_t written = static_cast<std::size_t>(res);
+                if (written < done.len)
+                    pwriteAll(fd, done.buf.data() + written, done.len - written, done.offset + written);
+                done.len = 0;
+            }
+        }
+#else
+        (void)s;
+#endif
+    }
+
+    void drain()
+    {
+        for (Slot& s : slots) wait(s);
+    }
+
+    void close()
+    {
+        if (fd < 0) return;
+        if (slots[cur].len > 0) submit(slots[cur]);
+        drain();
+        int rc = ::close(fd);
+        fd = -1;
+        if (rc != 0) throw std::runtime_error("write failed");
+    }
+
+    bool async() const
+    {
+#ifdef PAYROLL_HAVE_URING
+        return useRing;
+#else
+        return false;
+#endif
+    }
+};
+
+#endif
+
+RawWriter::RawWriter(const std::string& filename) : impl(new Impl(filename)) {}
+RawWriter::~RawWriter() = default;
+void RawWriter::write(const char* data, std::size_t len) { impl->write(data, len); }
+void RawWriter::close() { impl->close(); }
+bool RawWriter::async() const { return impl->async(); }
+
+// ===== RawReader =====
+
+#ifdef _WIN32
+
+struct RawReader::Impl {
+    std::FILE* file;
+    std::uint64_t expected;
+    std::uint64_t fileSize;
+
+    Impl(const std::string& filename, std::uint64_t startOffset)
+        : file(std::fopen(filename.c_str(), "rb")), expected(startOffset), fileSize(0)
+    {
+        if (!file) throw std::runtime_error("cannot open file: " + filename);
+        std::setvbuf(file, nullptr, _IOFBF, BlockSize);
+        if (_fseeki64(file, 0, SEEK_END) == 0) fileSize = static_cast<std::uint64_t>(_ftelli64(file));
+        if (_fseeki64(file, static_cast<long long>(startOffset), SEEK_SET) != 0) {
+            std::fclose(file);
+            throw std::runtime_error("seek failed: " + filename);
+        }
+    }
+    ~Impl() { std::fclose(file); }
+
+    std::size_t read(char* dst, std::size_t cap)
+    {
+        std::size_t n = std::fread(dst, 1, cap, file);
+        if (n == 0 && std::ferror(file)) throw std::runtime_error("read failed");
+        expected += n;
+        return n;
+    }
+
+    bool async() const { return false; }
+};
+
+#else
+
+//  : Depth    
+struct RawReader::Impl {
+    int fd;
+    std::uint64_t expected;
+    std::uint64_t fileSize;
+    bool eof;
+#ifdef PAYROLL_HAVE_URING
+    Slot slots[Depth];
+    unsigned cur;
+    std::uint64_t nextOffset;
+    Uring ring;
+    bool useRing;
+#endif
+
+    Impl(const std::string& filename, std::uint64_t startOffset)
+        : expected(startOffset), fileSize(0), eof(false)
+    {
+        fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::runtime_error("cannot open file: " + filename);
+        struct stat st;
+        if (fstat(fd, &st) == 0) fileSize = static_cast<std::uint64_t>(st.st_size);
+#ifdef PAYROLL_HAVE_URING
+        cur = 0;
+        nextOffset = startOffset;
+        useRing = ring.init(Depth);
+        if (useRing) {
+            for (Slot& s : slots) s.buf.resize(BlockSize);
+            for (Slot& s : slots) queue(s);
+            ring.enter(0);
+        }
+        else {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+#endif
+    }
+
+    ~Impl()
+    {
+#ifdef PAYROLL_HAVE_URING
+        //   ,     
+        try { drain(); }
+        catch (...) {}
+#endif
+        ::close(fd);
+    }
+
+#ifdef PAYROLL_HAVE_URING
+    void queue(Slot& s)
+    {
+        s.offset = nextOffset;
+        nextOffset += BlockSize;
+        s.len = s.pos = 0;
+        s.iov.iov_base = s.buf.data();
+        s.iov.iov_len = BlockSize;
+        s.busy = true;
+        ring.queue(IORING_OP_READV, fd, &s.iov, s.offset, static_cast<std::uint64_t>(&s - slots));
+    }
+
+    void wait(Slot& s)
+    {
+        while (s.busy) {
+            ring.enter(1);
+            std::uint64_t tag;
+            int res;
+            while (ring.reap(tag, res)) {
+                Slot& done = slots[tag];
+                done.busy = false;
+                if (res < 0) throw std::runtime_error("read failed");
+                done.len = static_cast<std::size_t>(res);
+            }
+        }
+    }
+
+    void drain()
+    {
+        for (Slot& s : slots) wait(s);
+    }
+#endif
+
+    std::size_t read(char* dst, std::size_t cap)
+    {
+        if (eof || cap == 0) return 0;
+#ifdef PAYROLL_HAVE_URING
+        if (useRing) {
+            Slot& s = slots[cur];
+            wait(s);
+            if (s.offset + s.pos != expected) throw std::runtime_error("read failed: out of order block");
+            if (s.len == 0) {
+                eof = true;
+                return 0;
+            }
+            std::size_t n = s.len - s.pos;
+            if (n > cap) n = cap;
+            std::memcpy(dst, s.buf.data() + s.pos, n);
+            s.pos += n;
+            expected += n;
+            if (s.pos == s.len) {
+                if (s.len < BlockSize) {
+                    //  : ,  ,   
+                    drain();
+                    nextOffset = expected;
+                    for (unsigned i = 1; i <= Depth; ++i) queue(slots[(cur + i) % Depth]);
+                }
+                else {
+                    queue(s);
+                }
+                ring.enter(0);
+                cur = (cur + 1) % Depth;
+            }
+            return n;
+        }
+#endif
+        std::size_t n = preadSome(fd, dst, cap, expected);
+        expected += n;
+        if (n == 0) eof = true;
+        return n;
+    }
+
+    bool async() const
+    {
+#ifdef PAYROLL_HAVE_URING
+        return useRing;
+#else
+        return false;
+#endif
+    }
+};
+
+#endif
+
+RawReader::RawReader(const std::string& filename, std::uint64_t startOffset)
+    : impl(new Impl(filename, startOffset)) {}
+RawReader::~RawReader() = default;
+std::size_t RawReader::read(char* dst, std::size_t cap) { return impl->read(dst, cap); }
+std::uint64_t RawReader::position() const { return impl->expected; }
+std::uint64_t RawReader::size() const { return impl->fileSize; }
+bool RawReader::async() const { return impl->async(); }
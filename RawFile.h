@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// =====   / =====
+//
+//  Linux    /    io_uring
+// (   ,  liburing).   io_uring 
+//    ,  pread/pwrite;  Windows 
+//  stdio.   FileIO.
+
+class RawWriter {
+public:
+    explicit RawWriter(const std::string& filename);
+    ~RawWriter();
+
+    RawWriter(const RawWriter&) = delete;
+    RawWriter& operator=(const RawWriter&) = delete;
+
+    void write(const char* data, std::size_t len);
+    //      
+    void close();
+
+    bool async() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+class RawReader {
+public:
+    explicit RawReader(const std::string& filename, std::uint64_t startOffset = 0);
+    ~RawReader();
+
+    RawReader(const RawReader&) = delete;
+    RawReader& operator=(const RawReader&) = delete;
+
+    //  0    
+    std::size_t read(char* dst, std::size_t cap);
+
+    //        
+    std::uint64_t position() const;
+    std::uint64_t size() const;
+
+    bool async() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
@@ -0,0 +1,396 @@
+#include "ShardedDb.h"
+#include "ContentHash.h"
+#include "FileIO.h"
+#include "ArrowIpc.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+const std::size_t ScanBatchRows = 4096;
+const std::size_t ScanQueueBatches = 4;   //     :     
+
+// work(i)   ,   ;   
+//  ,   
+template <class Work>
+void for_each_shard(std::size_t count, Work work)
+{
+    std::vector<std::exception_ptr> errors(count);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < count; ++i) {
+        threads.emplace_back([&errors, &work, i] {
+            try { work(i); }
+            catch (...) { errors[i] = std::current_exception(); }
+        });
+    }
+    try { if (count) work(0); }
+    catch (...) { errors[0] = std::current_exception(); }
+    for (std::thread& t : threads) t.join();
+    for (std::exception_ptr& e : errors) {
+        if (e) std::rethrow_exception(e);
+    }
+}
+
+bool by_name(const WorkTypeRow& a, const WorkTypeRow& b) { return a.name < b.name; }
+
+//   IX_WorkTypes_FinalPay: (FinalPay, Name)
+bool by_pay(const WorkTypeRow& a, const WorkTypeRow& b)
+{
+    if (a.finalPay != b.finalPay) return a.finalPay < b.finalPay;
+    return a.name < b.name;
+}
+
+bool by_pay_desc(const WorkTypeRow& a, const WorkTypeRow& b) { return by_pay(b, a); }
+
+// k-way  ,     less; limit 0   
+template <class Less>
+std::vector<WorkTypeRow> merge_parts(std::vector<std::vector<WorkTypeRow>>& parts, Less less, std::size_t limit)
+{
+    std::vector<std::size_t> pos(parts.size(), 0);
+    std::vector<std::size_t> heap;
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        total += parts[i].size();
+        if (!parts[i].empty()) heap.push_back(i);
+    }
+    if (limit && limit < total) total = limit;
+    //    : std::*_heap     
+    auto after = [&](std::size_t a, std::size_t b) { return less(parts[b][pos[b]], parts[a][pos[a]]); };
+    std::make_heap(heap.begin(), heap.end(), after);
+
+    std::vector<WorkTypeRow> out;
+    out.reserve(total);
+    while (!heap.empty() && out.size() < total) {
+        std::pop_heap(heap.begin(), heap.end(), after);
+        std::size_t i = heap.back();
+        out.push_back(std::move(parts[i][pos[i]]));
+        if (++pos[i] < parts[i].size()) std::push_heap(heap.begin(), heap.end(), after);
+        else heap.pop_back();
+    }
+    return out;
+}
+
+PayStats combine(const std::vector<PayStats>& parts)
+{
+    PayStats total;
+    for (const PayStats& p : parts) {
+        if (p.count == 0) continue;
+        if (total.count == 0 || p.minPay < total.minPay) total.minPay = p.minPay;
+        if (total.count == 0 || p.maxPay > total.maxPay) total.maxPay = p.maxPay;
+        total.count += p.count;
+        total.sum += p.sum;
+    }
+    if (total.count) total.average = total.sum / static_cast<double>(total.count);
+    return total;
+}
+
+//   : - ,   
+struct ShardStream {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<WorkTypeRow>> ready;
+    bool done = false;
+    bool stop = false;
+    std::exception_ptr error;
+
+    //   
+    std::vector<WorkTypeRow> current;
+    std::size_t pos = 0;
+
+    // false   ,   
+    bool push(std::vector<WorkTypeRow>& batch)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [&] { return stop || ready.size() < ScanQueueBatches; });
+        if (stop) return false;
+        ready.push_back(std::move(batch));
+        changed.notify_all();
+        return true;
+    }
+
+    void finish(std::exception_ptr failure)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        error = failure;
+        done = true;
+        changed.notify_all();
+    }
+
+    //    ;     
+    bool pull()
+    {
+        if (pos < current.size()) return true;
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [&] { return done || !ready.empty(); });
+        if (ready.empty()) {
+            if (error) std::rethrow_exception(error);
+            return false;
+        }
+        current = std::move(ready.front());
+        ready.pop_front();
+        pos = 0;
+        changed.notify_all();
+        return true;
+    }
+
+    const WorkTypeRow& head() const { return current[pos]; }
+};
+
+void read_shard(NativeDb& db, PageOrder orderBy, ShardStream& stream)
+{
+    std::exception_ptr failure;
+    try {
+        std::vector<WorkTypeRow> batch;
+        batch.reserve(ScanBatchRows);
+        for (const RowView& r : db.rows(orderBy)) {
+            batch.emplace_back();
+            WorkTypeRow& row = batch.back();
+            row.name.assign(r.name.data(), r.name.size());
+            row.basePay = r.basePay;
+            row.bonusPercent = r.bonusPercent;
+            //   ,    FinalPay,     
+            row.finalPay = r.basePay * (1.0 + r.bonusPercent / 100.0);
+            if (batch.size() == ScanBatchRows) {
+                if (!stream.push(batch)) return;
+                batch.clear();
+                batch.reserve(ScanBatchRows);
+            }
+        }
+        if (!batch.empty() && !stream.push(batch)) return;
+    }
+    catch (...) {
+        failure = std::current_exception();
+    }
+    stream.finish(failure);
+}
+
+//   ;     ,  
+//  (  )      
+class ShardScan {
+public:
+    ShardScan(std::vector<std::unique_ptr<NativeDb>>& shards, PageOrder orderBy)
+        : streams(shards.size())
+    {
+        for (std::size_t i = 0; i < shards.size(); ++i) {
+            streams[i].reset(new ShardStream());
+            threads.emplace_back(read_shard, std::ref(*shards[i]), orderBy, std::ref(*streams[i]));
+        }
+    }
+
+    ~ShardScan()
+    {
+        for (auto& s : streams) {
+            std::lock_guard<std::mutex> guard(s->lock);
+            s->stop = true;
+            s->changed.notify_all();
+        }
+        for (std::thread& t : threads) t.join();
+    }
+
+    ShardScan(const ShardScan&) = delete;
+    ShardScan& operator=(const ShardScan&) = delete;
+
+    std::vector<std::unique_ptr<ShardStream>> streams;
+
+private:
+    std::vector<std::thread> threads;
+};
+
+} // namespace
+
+// ===== ShardedDb =====
+
+ShardedDb::ShardedDb(const std::string& dbPath, unsigned shardCount, const DbOptions& options)
+{
+    if (shardCount == 0) throw std::invalid_argument("ShardedDb: shardCount must be positive");
+    //   ( ) 
+    shards.resize(shardCount);
+    for_each_shard(shardCount, [&](std::size_t i) {
+        unsigned shard = static_cast<unsigned>(i);
+        DbOptions own = options;
+        //     ,       
+        if (!own.statsDumpPath.empty()) own.statsDumpPath = shardPath(options.statsDumpPath, shard, shardCount);
+        shards[i].reset(new NativeDb(shardPath(dbPath, shard, shardCount), own));
+    });
+}
+
+ShardedDb::~ShardedDb() {}
+
+std::string ShardedDb::shardPath(const std::string& dbPath, unsigned shard, unsigned shardCount)
+{
+    std::string tag = "." + std::to_string(shard) + "-of-" + std::to_string(shardCount);
+    std::size_t slash = dbPath.find_last_of("/\\");
+    std::size_t dot = dbPath.rfind('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash) || dot == slash + 1)
+        return dbPath + tag;
+    return dbPath.substr(0, dot) + tag + dbPath.substr(dot);
+}
+
+//     :         
+unsigned ShardedDb::shardOf(std::string_view name) const
+{
+    Xxh64 hash;
+    hash.update(name.data(), name.size());
+    return static_cast<unsigned>(hash.digest() % shards.size());
+}
+
+UpsertResult ShardedDb::upsert(const std::string& name, double basePay, double bonusPercent)
+{
+    return shards[shardOf(name)]->upsert(name, basePay, bonusPercent);
+}
+
+void ShardedDb::insertOrReplace(const std::string& name, double basePay, double bonusPercent)
+{
+    shards[shardOf(name)]->insertOrReplace(name, basePay, bonusPercent);
+}
+
+bool ShardedDb::find(const std::string& name, WorkTypeRow& row)
+{
+    return shards[shardOf(name)]->find(name, row);
+}
+
+UpsertCounts ShardedDb::insertMany(const std::vector<std::tuple<std::string, double, double>>& rows,
+    const InsertOptions& options)
+{
+    struct Part {
+        std::vector<std::string> names;
+        std::vector<double> basePay;
+        std::vector<double> bonusPercent;
+    };
+    std::vector<Part> parts(shards.size());
+    for (const auto& row : rows) {
+        Part& p = parts[shardOf(std::get<0>(row))];
+        p.names.push_back(std::get<0>(row));
+        p.basePay.push_back(std::get<1>(row));
+        p.bonusPercent.push_back(std::get<2>(row));
+    }
+
+    std::vector<UpsertCounts> counts(shards.size());
+    for_each_shard(shards.size(), [&](std::size_t i) {
+        const Part& p = parts[i];
+        if (p.names.empty()) return;
+        counts[i] = shards[i]->insertMany(p.names.data(), p.basePay.data(), p.bonusPercent.data(),
+            p.names.size(), options);
+    });
+    UpsertCounts total;
+    for (const UpsertCounts& c : counts) {
+        total.inserted += c.inserted;
+        total.updated += c.updated;
+        total.unchanged += c.unchanged;
+    }
+    return total;
+}
+
+void ShardedDb::clearTable()
+{
+    for_each_shard(shards.size(), [&](std::size_t i) { shards[i]->clearTable(); });
+}
+
+std::vector<std::tuple<std::string, double, double>> ShardedDb::getAll()
+{
+    std::vector<std::tuple<std::string, double, double>> out;
+    scan(PageOrder::Name, [&](const WorkTypeRow& r) {
+        out.emplace_back(r.name, r.basePay, r.bonusPercent);
+    });
+    return out;
+}
+
+//      limit      
+//    limit
+std::vector<WorkTypeRow> ShardedDb::getByPayRange(double minPay, double maxPay, std::size_t limit)
+{
+    std::vector<std::vector<WorkTypeRow>> parts(shards.size());
+    for_each_shard(shards.size(), [&](std::size_t i) {
+        parts[i] = shards[i]->getByPayRange(minPay, maxPay, limit);
+    });
+    return merge_parts(parts, by_pay, limit);
+}
+
+std::vector<WorkTypeRow> ShardedDb::topByPay(std::size_t k)
+{
+    if (k == 0) return std::vector<WorkTypeRow>();
+    std::vector<std::vector<WorkTypeRow>> parts(shards.size());
+    for_each_shard(shards.size(), [&](std::size_t i) { parts[i] = shards[i]->topByPay(k); });
+    return merge_parts(parts, by_pay_desc, k);
+}
+
+PayStats ShardedDb::payStats()
+{
+    std::vector<PayStats> parts(shards.size());
+    for_each_shard(shards.size(), [&](std::size_t i) { parts[i] = shards[i]->payStats(); });
+    return combine(parts);
+}
+
+PayStats ShardedDb::payStats(double minPay, double maxPay)
+{
+    std::vector<PayStats> parts(shards.size());
+    for_each_shard(shards.size(), [&](std::size_t i) { parts[i] = shards[i]->payStats(minPay, maxPay); });
+    return combine(parts);
+}
+
+void ShardedDb::scan(PageOrder orderBy, const std::function<void(const WorkTypeRow&)>& visit)
+{
+    bool (*less)(const WorkTypeRow&, const WorkTypeRow&) = orderBy == PageOrder::Name ? by_name : by_pay;
+    ShardScan scan(shards, orderBy);
+    auto& streams = scan.streams;
+
+    std::vector<std::size_t> heap;
+    for (std::size_t i = 0; i < streams.size(); ++i) {
+        if (streams[i]->pull()) heap.push_back(i);
+    }
+    auto after = [&](std::size_t a, std::size_t b) { return less(streams[b]->head(), streams[a]->head()); };
+    std::make_heap(heap.begin(), heap.end(), after);
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), after);
+        ShardStream& s = *streams[heap.back()];
+        visit(s.head());
+        ++s.pos;
+        if (s.pull()) std::push_heap(heap.begin(), heap.end(), after);
+        else heap.pop_back();
+    }
+}
+
+ExportStats ShardedDb::exportToFile(const std::string& filename, const ExportOptions& options)
+{
+    std::size_t total = payStats().count;
+    if (!ArrowWriter::isArrowFile(filename)) {
+        CsvExportWriter writer(filename, total, options);
+        scan(PageOrder::Name, [&](const WorkTypeRow& r) {
+            writer.append(r.name, r.basePay, r.bonusPercent);
+        });
+        return writer.finish();
+    }
+
+    ExportStats stats;
+    ProgressMeter meter(options.progress, options.progressInterval, 0, total);
+    try {
+        ArrowWriter writer(filename, ArrowWriter::formatForFile(filename), options.arrowBatchRows);
+        scan(PageOrder::Name, [&](const WorkTypeRow& r) {
+            writer.append(r.name, r.basePay, r.bonusPercent);
+            if ((++stats.rowsExported & 4095) == 0) {
+                if (options.cancel) options.cancel->check();
+                meter.update(writer.bytesWritten(), stats.rowsExported, 0);
+            }
+        });
+        if (options.cancel) options.cancel->check();
+        writer.close();
+        stats.bytesWritten = writer.bytesWritten();
+    }
+    catch (...) {
+        std::remove(filename.c_str());
+        throw;
+    }
+    meter.update(stats.bytesWritten, stats.rowsExported, 0);
+    ProgressInfo info = meter.finish();
+    stats.seconds = info.elapsedSeconds;
+    stats.rowsPerSecond = info.rowsPerSecond;
+    stats.bytesPerSecond = info.bytesPerSecond;
+    return stats;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "NativeDb.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+// =====  WorkTypes   =====
+//
+//    XXH64   shardCount ,   
+// NativeDb   -   ,    
+//      .         ,
+//       ,   .
+//
+//  : "payroll.db" -> "payroll.2-of-8.db".    
+// ,  ,    ,   ,  
+//  .        .
+// DbOptions::statsDumpPath    : "stats.json" -> "stats.2-of-8.json".
+//      :    
+//  ,  .
+
+class ShardedDb {
+public:
+    ShardedDb(const std::string& dbPath, unsigned shardCount, const DbOptions& options = DbOptions());
+    ~ShardedDb();
+
+    ShardedDb(const ShardedDb&) = delete;
+    ShardedDb& operator=(const ShardedDb&) = delete;
+
+    static std::string shardPath(const std::string& dbPath, unsigned shard, unsigned shardCount);
+    unsigned shardCount() const { return static_cast<unsigned>(shards.size()); }
+    unsigned shardOf(std::string_view name) const;
+    NativeDb& shard(unsigned index) { return *shards[index]; }
+
+    //  - 
+    UpsertResult upsert(const std::string& name, double basePay, double bonusPercent);
+    void insertOrReplace(const std::string& name, double basePay, double bonusPercent);
+    bool find(const std::string& name, WorkTypeRow& row);
+
+    //    ,   ,   
+    UpsertCounts insertMany(const std::vector<std::tuple<std::string, double, double>>& rows,
+        const InsertOptions& options = InsertOptions());
+    void clearTable();
+
+    //   ,    
+    std::vector<std::tuple<std::string, double, double>> getAll();
+    std::vector<WorkTypeRow> getByPayRange(double minPay, double maxPay, std::size_t limit = 0);
+    std::vector<WorkTypeRow> topByPay(std::size_t k);
+    PayStats payStats();
+    PayStats payStats(double minPay, double maxPay);
+
+    //       orderBy:     
+    //  ,        visit.
+    //   visit    .
+    void scan(PageOrder orderBy, const std::function<void(const WorkTypeRow&)>& visit);
+    //  NativeDb::exportToFile: CSV  Arrow  ,   
+    ExportStats exportToFile(const std::string& filename, const ExportOptions& options = ExportOptions());
+
+private:
+    std::vector<std::unique_ptr<NativeDb>> shards;
+};